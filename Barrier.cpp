@@ -0,0 +1,27 @@
+//
+// Created by tetrukavi on 02/05/2021.
+//
+
+#include "Barrier.h"
+
+
+/*
+ * This is the constructor of the barrier
+ */
+Barrier::Barrier(int parties) : parties(parties) {
+}
+
+/*
+ * This function returns the queue of the threads that arrived in this round
+ */
+ThreadQueue &Barrier::get_waiters() {
+    return waiters;
+}
+
+/*
+ * This function returns true if the next thread to arrive is the last one
+ * of the round
+ */
+bool Barrier::completed_by_next() const {
+    return waiters.size() + 1 >= parties;
+}
@@ -0,0 +1,37 @@
+//
+// Created by tetrukavi on 02/05/2021.
+//
+
+#ifndef OS_EX2_BARRIER_H
+#define OS_EX2_BARRIER_H
+
+#include "Thread.h"
+#include "ThreadQueue.h"
+
+
+/*
+ * This class represents a barrier - the number of threads that must arrive
+ * at it, and the threads that arrived and wait for the others. The arrived
+ * threads are counted by their queue, so a waiting thread that terminates
+ * is no longer counted.
+ */
+class Barrier {
+
+private:
+
+    int parties; // threads that pass the barrier together
+    ThreadQueue waiters; // the threads that arrived in this round
+
+
+public:
+
+    explicit Barrier(int parties);
+
+    ThreadQueue &get_waiters();
+    bool completed_by_next() const;
+
+};
+
+
+
+#endif //OS_EX2_BARRIER_H
@@ -0,0 +1,25 @@
+//
+// Created by tetrukavi on 02/05/2021.
+//
+
+#include "CondVar.h"
+
+
+/*
+ * This function returns the queue of the threads that wait on the condition
+ */
+ThreadQueue &CondVar::get_waiters() {
+    return waiters;
+}
+
+/*
+ * This function returns the mutex the waiting threads released, nullptr if
+ * no thread waited yet
+ */
+Mutex *CondVar::get_mutex() const {
+    return mutex;
+}
+
+void CondVar::set_mutex(Mutex *waiters_mutex) {
+    mutex = waiters_mutex;
+}
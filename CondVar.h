@@ -0,0 +1,37 @@
+//
+// Created by tetrukavi on 02/05/2021.
+//
+
+#ifndef OS_EX2_CONDVAR_H
+#define OS_EX2_CONDVAR_H
+
+#include "Thread.h"
+#include "ThreadQueue.h"
+#include "Mutex.h"
+
+
+/*
+ * This class represents a condition variable - the threads that wait on it,
+ * and the mutex they released to wait. A signalled waiter is moved straight
+ * to the waiters of that mutex (or given the mutex, if it is unlocked), so
+ * it wakes up only when it holds the mutex again.
+ */
+class CondVar {
+
+private:
+
+    ThreadQueue waiters; // the threads that wait on the condition -> first in first out
+    Mutex *mutex = nullptr; // the mutex of the waiting threads
+
+
+public:
+
+    ThreadQueue &get_waiters();
+    Mutex *get_mutex() const;
+    void set_mutex(Mutex *waiters_mutex);
+
+};
+
+
+
+#endif //OS_EX2_CONDVAR_H
@@ -0,0 +1,54 @@
+//
+// Created by tetrukavi on 02/05/2021.
+//
+
+#include "DeadlineQueue.h"
+#include "Reservation.h"
+#include <algorithm>
+#include <functional>
+
+
+/*
+ * This function orders the entries of the heap by deadline
+ */
+bool DeadlineQueue::Entry::operator>(const Entry &other) const {
+    return deadline > other.deadline;
+}
+
+/*
+ * This function returns true if the queue has no threads
+ */
+bool DeadlineQueue::empty() const {
+    return heap.empty();
+}
+
+/*
+ * This function returns the number of threads in the queue
+ */
+long DeadlineQueue::size() const {
+    return (long)heap.size();
+}
+
+/*
+ * This function pushes the periodic thread, with its ready ticket, by the
+ * deadline of its current job
+ */
+void DeadlineQueue::push(Thread *thread) {
+    heap.push_back({thread->get_reservation()->get_deadline(), thread, thread->get_ready_ticket()});
+    std::push_heap(heap.begin(), heap.end(), std::greater<Entry>());
+}
+
+/*
+ * This function takes the thread with the earliest deadline, and the ticket
+ * it was pushed with - nullptr if the queue is empty
+ */
+Thread *DeadlineQueue::pop(unsigned long *ticket) {
+    if (heap.empty()) {
+        return nullptr;
+    }
+    std::pop_heap(heap.begin(), heap.end(), std::greater<Entry>());
+    Entry first = heap.back();
+    heap.pop_back();
+    *ticket = first.ticket;
+    return first.thread;
+}
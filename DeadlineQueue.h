@@ -0,0 +1,45 @@
+//
+// Created by tetrukavi on 02/05/2021.
+//
+
+#ifndef OS_EX2_DEADLINEQUEUE_H
+#define OS_EX2_DEADLINEQUEUE_H
+
+#include <vector>
+#include "Thread.h"
+
+
+/*
+ * This class is the ready queue of the periodic threads (see
+ * uthread_spawn_periodic): a min-heap keyed on the absolute deadline of
+ * their current job, so the earliest deadline runs first (EDF). It is
+ * shared by all the workers, and used only in the library's critical
+ * section.
+ */
+class DeadlineQueue {
+
+private:
+
+    struct Entry {
+        unsigned long deadline; // of the thread when it was pushed
+        Thread *thread;
+        unsigned long ticket;
+
+        bool operator>(const Entry &other) const;
+    };
+
+    std::vector<Entry> heap;
+
+
+public:
+
+    bool empty() const;
+    long size() const;
+    void push(Thread *thread);
+    Thread *pop(unsigned long *ticket);
+
+};
+
+
+
+#endif //OS_EX2_DEADLINEQUEUE_H
@@ -0,0 +1,66 @@
+//
+// Created by tetrukavi on 02/05/2021.
+//
+
+#include "FairRunQueue.h"
+#include <algorithm>
+#include <functional>
+
+
+/*
+ * This function orders the entries of the heap - by virtual runtime, then
+ * by the order they were pushed
+ */
+bool FairRunQueue::Entry::operator>(const Entry &other) const {
+    if (vruntime != other.vruntime) {
+        return vruntime > other.vruntime;
+    }
+    return order > other.order;
+}
+
+/*
+ * This function returns true if the queue has no threads
+ */
+bool FairRunQueue::empty() const {
+    return heap.empty();
+}
+
+/*
+ * This function returns the number of threads in the queue
+ */
+long FairRunQueue::size() const {
+    return (long)heap.size();
+}
+
+/*
+ * This function returns the smallest virtual runtime the queue has handed
+ * out - threads that join the queue after a wait are placed relative to it
+ */
+unsigned long FairRunQueue::get_min_vruntime() const {
+    return min_vruntime;
+}
+
+/*
+ * This function pushes the thread, with its ready ticket, by its virtual
+ * runtime
+ */
+void FairRunQueue::push(Thread *thread) {
+    heap.push_back({thread->get_vruntime(), pushed++, thread, thread->get_ready_ticket()});
+    std::push_heap(heap.begin(), heap.end(), std::greater<Entry>());
+}
+
+/*
+ * This function takes the thread with the smallest virtual runtime, and the
+ * ticket it was pushed with - nullptr if the queue is empty
+ */
+Thread *FairRunQueue::pop(unsigned long *ticket) {
+    if (heap.empty()) {
+        return nullptr;
+    }
+    std::pop_heap(heap.begin(), heap.end(), std::greater<Entry>());
+    Entry first = heap.back();
+    heap.pop_back();
+    min_vruntime = std::max(min_vruntime, first.vruntime);
+    *ticket = first.ticket;
+    return first.thread;
+}
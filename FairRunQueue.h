@@ -0,0 +1,51 @@
+//
+// Created by tetrukavi on 02/05/2021.
+//
+
+#ifndef OS_EX2_FAIRRUNQUEUE_H
+#define OS_EX2_FAIRRUNQUEUE_H
+
+#include <vector>
+#include "Thread.h"
+
+
+/*
+ * This class is the ready queue of a worker in fair scheduling (see
+ * uthread_options_t): a min-heap of the threads keyed on their virtual
+ * runtime, so the thread that ran the least (by weight) runs next. Threads
+ * with the same virtual runtime run in the order they were pushed. Unlike
+ * RunQueue it is not lock-free - every worker uses it only in the
+ * library's critical section.
+ */
+class FairRunQueue {
+
+private:
+
+    struct Entry {
+        unsigned long vruntime; // of the thread when it was pushed
+        unsigned long order; // breaks ties - first pushed first
+        Thread *thread;
+        unsigned long ticket;
+
+        bool operator>(const Entry &other) const;
+    };
+
+    std::vector<Entry> heap;
+    unsigned long pushed = 0;
+    // never decreases - the smallest virtual runtime the queue has handed out
+    unsigned long min_vruntime = 0;
+
+
+public:
+
+    bool empty() const;
+    long size() const;
+    unsigned long get_min_vruntime() const;
+    void push(Thread *thread);
+    Thread *pop(unsigned long *ticket);
+
+};
+
+
+
+#endif //OS_EX2_FAIRRUNQUEUE_H
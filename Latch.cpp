@@ -0,0 +1,38 @@
+//
+// Created by tetrukavi on 02/05/2021.
+//
+
+#include "Latch.h"
+
+
+/*
+ * This is the constructor of the count down
+ */
+Latch::Latch(long initial_count) : count(initial_count) {
+}
+
+/*
+ * This function returns the count
+ */
+long Latch::get_count() const {
+    return count;
+}
+
+/*
+ * This function returns the queue of the threads that wait for zero
+ */
+ThreadQueue &Latch::get_waiters() {
+    return waiters;
+}
+
+/*
+ * This function adds delta (may be negative) to the count. It returns false
+ * (and leaves the count) if the count would become negative
+ */
+bool Latch::add(long delta) {
+    if (count + delta < 0) {
+        return false;
+    }
+    count += delta;
+    return true;
+}
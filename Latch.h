@@ -0,0 +1,37 @@
+//
+// Created by tetrukavi on 02/05/2021.
+//
+
+#ifndef OS_EX2_LATCH_H
+#define OS_EX2_LATCH_H
+
+#include "Thread.h"
+#include "ThreadQueue.h"
+
+
+/*
+ * This class represents a count down - a count and the threads that wait
+ * for it to reach zero. It backs both the latches, which only count down,
+ * and the wait groups, whose count may also go up again.
+ */
+class Latch {
+
+private:
+
+    long count; // the count the waiting threads wait to reach zero
+    ThreadQueue waiters; // the threads that wait for zero
+
+
+public:
+
+    explicit Latch(long initial_count);
+
+    long get_count() const;
+    ThreadQueue &get_waiters();
+    bool add(long delta);
+
+};
+
+
+
+#endif //OS_EX2_LATCH_H
@@ -0,0 +1,54 @@
+//
+// Created by tetrukavi on 02/05/2021.
+//
+
+#include "Mutex.h"
+
+
+/*
+ * This function returns true if some thread holds the mutex
+ */
+bool Mutex::is_locked() const {
+    return owner != -1;
+}
+
+/*
+ * This function returns the tid of the thread that holds the mutex, -1 if unlocked
+ */
+int Mutex::get_owner() const {
+    return owner;
+}
+
+/*
+ * This function returns the queue of the threads that wait for the mutex
+ */
+ThreadQueue &Mutex::get_waiters() {
+    return waiters;
+}
+
+/*
+ * This function makes the thread the owner of the (unlocked) mutex
+ */
+void Mutex::acquire(Thread *thread) {
+    owner = thread->get_tid();
+    next_held = thread->get_held_mutexes();
+    thread->set_held_mutexes(this);
+}
+
+/*
+ * This function unlocks the mutex, which is held by the given thread
+ */
+void Mutex::release(Thread *thread) {
+    owner = -1;
+    if (thread->get_held_mutexes() == this) {
+        thread->set_held_mutexes(next_held);
+    }
+    else {
+        Mutex *held = thread->get_held_mutexes();
+        while (held->next_held != this) {
+            held = held->next_held;
+        }
+        held->next_held = next_held;
+    }
+    next_held = nullptr;
+}
@@ -0,0 +1,38 @@
+//
+// Created by tetrukavi on 02/05/2021.
+//
+
+#ifndef OS_EX2_MUTEX_H
+#define OS_EX2_MUTEX_H
+
+#include "Thread.h"
+#include "ThreadQueue.h"
+
+
+/*
+ * This class represents a mutex object - its owner and the threads that
+ * wait for it. The mutexes a thread holds are linked through next_held,
+ * so they can be released when the thread terminates.
+ */
+class Mutex {
+
+private:
+
+    int owner = -1; // tid of the thread that holds the mutex, -1 if unlocked
+    ThreadQueue waiters; // the threads that wait for the mutex -> first in first out
+    Mutex *next_held = nullptr; // the next mutex held by the same owner
+
+
+public:
+
+    bool is_locked() const;
+    int get_owner() const;
+    ThreadQueue &get_waiters();
+    void acquire(Thread *thread);
+    void release(Thread *thread);
+
+};
+
+
+
+#endif //OS_EX2_MUTEX_H
@@ -0,0 +1,114 @@
+//
+// Created by tetrukavi on 02/05/2021.
+//
+
+#include "RWLock.h"
+
+
+/*
+ * This is the constructor of the reader-writer lock
+ */
+RWLock::RWLock(bool prefer_writers) : prefer_writers(prefer_writers) {
+}
+
+/*
+ * This function returns true if a reader or a writer holds the lock
+ */
+bool RWLock::is_locked() const {
+    return (readers > 0) || (writer != -1);
+}
+
+/*
+ * This function returns true if threads wait for the lock
+ */
+bool RWLock::has_waiters() const {
+    return !waiting_readers.empty() || !waiting_writers.empty();
+}
+
+/*
+ * This function returns the tid of the thread that holds the lock for
+ * writing, -1 if none
+ */
+int RWLock::get_writer() const {
+    return writer;
+}
+
+/*
+ * This function returns the queue of the readers that wait for the lock
+ */
+ThreadQueue &RWLock::get_waiting_readers() {
+    return waiting_readers;
+}
+
+/*
+ * This function returns the queue of the writers that wait for the lock
+ */
+ThreadQueue &RWLock::get_waiting_writers() {
+    return waiting_writers;
+}
+
+/*
+ * This function takes the lock for reading for the thread, if no writer
+ * holds it (or, with writer preference, waits for it - unless the thread
+ * holds it for reading already, which would wait for itself). It returns
+ * true if it did
+ */
+bool RWLock::try_read_lock(Thread *thread) {
+    if ((writer != -1) || (prefer_writers && !waiting_writers.empty() && !thread->holds_rwlock(this))) {
+        return false;
+    }
+    readers++;
+    thread->add_held_rwlock(this);
+    return true;
+}
+
+/*
+ * This function takes the lock for writing for the thread, if no thread
+ * holds it. It returns true if it did
+ */
+bool RWLock::try_write_lock(Thread *thread) {
+    if (is_locked()) {
+        return false;
+    }
+    writer = thread->get_tid();
+    thread->add_held_rwlock(this);
+    return true;
+}
+
+/*
+ * This function releases a hold of the lock by the thread - the writer, or
+ * one of the readers. If that frees it, it is handed to the threads that
+ * wait for it, which move to the end of woken: all the readers after a
+ * writer (or if no writer waits), or else the first writer. It returns
+ * false (and does nothing) if the thread doesn't hold the lock.
+ */
+bool RWLock::release(Thread *thread, ThreadQueue &woken) {
+    if (!thread->remove_held_rwlock(this)) {
+        return false;
+    }
+    bool by_writer = (writer != -1);
+    if (by_writer) {
+        writer = -1;
+    }
+    else {
+        readers--;
+    }
+    if (readers > 0) {
+        return true;
+    }
+    if (!waiting_readers.empty() && (by_writer || waiting_writers.empty())) {
+        while (!waiting_readers.empty()) {
+            Thread *next_reader = waiting_readers.pop_front();
+            readers++;
+            next_reader->add_held_rwlock(this);
+            woken.push_back(next_reader);
+        }
+    }
+    else if (!waiting_writers.empty()) {
+        Thread *next_writer = waiting_writers.pop_front();
+        writer = next_writer->get_tid();
+        next_writer->add_held_rwlock(this);
+        woken.push_back(next_writer);
+    }
+    return true;
+}
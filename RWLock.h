@@ -0,0 +1,53 @@
+//
+// Created by tetrukavi on 02/05/2021.
+//
+
+#ifndef OS_EX2_RWLOCK_H
+#define OS_EX2_RWLOCK_H
+
+#include "Thread.h"
+#include "ThreadQueue.h"
+
+
+/*
+ * This class represents a reader-writer lock - held by any number of
+ * readers, or by one writer - and the readers and writers that wait for it.
+ * The lock is handed directly to the threads it wakes: when a writer
+ * releases it, all the waiting readers get it together (or else the first
+ * waiting writer), and when the last reader releases it, the first waiting
+ * writer gets it. With writer preference a new reader waits while a writer
+ * waits, so the readers can't starve the writers - and since the readers
+ * that waited meanwhile go in one batch after the writer, the writers
+ * can't starve the readers either. Every thread records the locks it holds
+ * (see Thread::add_held_rwlock), so only a holder releases a lock, and a
+ * terminated thread releases the locks it holds.
+ */
+class RWLock {
+
+private:
+
+    int readers = 0; // threads that hold the lock for reading
+    int writer = -1; // tid of the thread that holds the lock for writing, -1 if none
+    bool prefer_writers;
+    ThreadQueue waiting_readers; // -> first in first out
+    ThreadQueue waiting_writers; // -> first in first out
+
+
+public:
+
+    explicit RWLock(bool prefer_writers);
+
+    bool is_locked() const;
+    bool has_waiters() const;
+    int get_writer() const;
+    ThreadQueue &get_waiting_readers();
+    ThreadQueue &get_waiting_writers();
+    bool try_read_lock(Thread *thread);
+    bool try_write_lock(Thread *thread);
+    bool release(Thread *thread, ThreadQueue &woken);
+
+};
+
+
+
+#endif //OS_EX2_RWLOCK_H
@@ -0,0 +1,140 @@
+//
+// Created by tetrukavi on 02/05/2021.
+//
+
+#include "Reservation.h"
+
+#define DENSITY_SCALE 1000000000UL // a density of 1 - the thread needs a whole CPU
+
+
+/*
+ * This is the constructor of the reservation
+ */
+Reservation::Reservation(unsigned long period, unsigned long budget, unsigned long relative_deadline) :
+        period(period), budget(budget), relative_deadline(relative_deadline) {
+}
+
+/*
+ * This function returns the share of a CPU the thread may need, in
+ * billionths - its budget in every window of its deadline
+ */
+unsigned long Reservation::get_density() const {
+    return (unsigned long)((double)budget / (double)relative_deadline * DENSITY_SCALE);
+}
+
+/*
+ * This function returns the absolute deadline the thread is scheduled by
+ */
+unsigned long Reservation::get_deadline() const {
+    return deadline;
+}
+
+/*
+ * This function returns when the current period started - while the
+ * thread waits, when the next one starts
+ */
+unsigned long Reservation::get_release_time() const {
+    return period_start;
+}
+
+/*
+ * This function returns true if the thread used up its budget in this period
+ */
+bool Reservation::budget_exhausted() const {
+    return budget_left <= 0;
+}
+
+/*
+ * This function releases the first job at now
+ */
+void Reservation::start(unsigned long now) {
+    period_start = now;
+    release();
+}
+
+/*
+ * This function releases a job at get_release_time, with a full budget
+ */
+void Reservation::release() {
+    budget_left = (long)budget;
+    deadline = period_start + relative_deadline;
+    job_release = period_start;
+    job_deadline = deadline;
+    job_time = 0;
+}
+
+/*
+ * This function charges the CPU time the thread ran to its budget
+ */
+void Reservation::charge(unsigned long run_time) {
+    budget_left -= (long)run_time;
+    job_time += run_time;
+}
+
+/*
+ * This function completes the current job at now - the next job is released
+ * in the next period, or at once if it has already started (a late job
+ * skips the periods that passed, so the jobs don't pile up)
+ */
+void Reservation::complete_job(unsigned long now) {
+    jobs++;
+    if (now > job_deadline) {
+        missed_deadlines++;
+    }
+    if (job_time > max_job_time) {
+        max_job_time = job_time;
+    }
+    if (now - job_release > max_response_time) {
+        max_response_time = now - job_release;
+    }
+    period_start += period;
+    if (now > period_start) {
+        period_start += (now - period_start) / period * period;
+    }
+}
+
+/*
+ * This function postpones the current job, which used up its budget - it
+ * gets the budget of the next period, and the deadline one period later
+ */
+void Reservation::postpone() {
+    overruns++;
+    budget_left += (long)budget;
+    deadline += period;
+}
+
+/*
+ * This function returns the number of jobs completed
+ */
+int Reservation::get_jobs() const {
+    return jobs;
+}
+
+/*
+ * This function returns the number of jobs completed after their deadline
+ */
+int Reservation::get_missed_deadlines() const {
+    return missed_deadlines;
+}
+
+/*
+ * This function returns the number of times a job used up its budget
+ */
+int Reservation::get_overruns() const {
+    return overruns;
+}
+
+/*
+ * This function returns the CPU time of the longest job
+ */
+unsigned long Reservation::get_max_job_time() const {
+    return max_job_time;
+}
+
+/*
+ * This function returns the longest time from the release of a job to its
+ * completion
+ */
+unsigned long Reservation::get_max_response_time() const {
+    return max_response_time;
+}
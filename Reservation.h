@@ -0,0 +1,67 @@
+//
+// Created by tetrukavi on 02/05/2021.
+//
+
+#ifndef OS_EX2_RESERVATION_H
+#define OS_EX2_RESERVATION_H
+
+
+/*
+ * This class represents the CPU reservation of a periodic thread (see
+ * uthread_spawn_periodic): a job is released every period, and must run
+ * (up to budget CPU time) before its deadline. The threads are scheduled by
+ * the absolute deadline of their current job (EDF). A job that uses up its
+ * budget is postponed, as in a constant bandwidth server - it goes on with
+ * the budget of the next period, scheduled by a deadline one period later
+ * (but it is still late by its own deadline).
+ * All the times are in nanoseconds - CPU time for the budget, and
+ * CLOCK_MONOTONIC for the releases and deadlines.
+ */
+class Reservation {
+
+private:
+
+    unsigned long period;
+    unsigned long budget;
+    unsigned long relative_deadline;
+
+    unsigned long period_start = 0; // of the current period (the next, while waiting for it)
+    unsigned long deadline = 0; // the thread is scheduled by it - the job's, or later if it was postponed
+    long budget_left = 0;
+
+    // the current job
+    unsigned long job_release = 0;
+    unsigned long job_deadline = 0;
+    unsigned long job_time = 0;
+
+    // statistics
+    int jobs = 0;
+    int missed_deadlines = 0;
+    int overruns = 0;
+    unsigned long max_job_time = 0;
+    unsigned long max_response_time = 0;
+
+public:
+
+    Reservation(unsigned long period, unsigned long budget, unsigned long relative_deadline);
+
+    unsigned long get_density() const;
+    unsigned long get_deadline() const;
+    unsigned long get_release_time() const;
+    bool budget_exhausted() const;
+    void start(unsigned long now);
+    void release();
+    void charge(unsigned long run_time);
+    void complete_job(unsigned long now);
+    void postpone();
+    int get_jobs() const;
+    int get_missed_deadlines() const;
+    int get_overruns() const;
+    unsigned long get_max_job_time() const;
+    unsigned long get_max_response_time() const;
+
+};
+
+
+
+#endif //OS_EX2_RESERVATION_H
@@ -0,0 +1,83 @@
+//
+// Created by tetrukavi on 02/05/2021.
+//
+
+#include "RunQueue.h"
+
+static_assert(PRIORITY_LEVELS <= 64, "the levels bitmap is one 64 bit word");
+
+
+/*
+ * This function returns true if the queue has no threads
+ */
+bool RunQueue::empty() const {
+    return size() == 0;
+}
+
+/*
+ * This function returns the number of threads in the queue (only the levels
+ * of the bitmap are counted)
+ */
+long RunQueue::size() const {
+    long size = 0;
+    for (uint64_t bits = non_empty_levels.load(); bits != 0; bits &= bits - 1) {
+        size += levels[__builtin_ctzll(bits)].size();
+    }
+    return size;
+}
+
+/*
+ * This function returns the most urgent priority that may have threads,
+ * PRIORITY_LEVELS if there is none
+ */
+int RunQueue::most_urgent_priority() const {
+    uint64_t bits = non_empty_levels.load();
+    return bits == 0 ? PRIORITY_LEVELS : __builtin_ctzll(bits);
+}
+
+/*
+ * This function pushes the thread, with its ready ticket, at the end of the
+ * level of the given priority (owner only)
+ */
+void RunQueue::push(Thread *thread, int priority) {
+    levels[priority].push(thread, thread->get_ready_ticket());
+    non_empty_levels.fetch_or((uint64_t)1 << priority);
+}
+
+/*
+ * This function takes the first thread of the most urgent level, and the
+ * ticket it was pushed with - nullptr if the queue is empty (owner only)
+ */
+Thread *RunQueue::pop(unsigned long *ticket) {
+    while (true) {
+        uint64_t bits = non_empty_levels.load();
+        if (bits == 0) {
+            return nullptr;
+        }
+        int priority = __builtin_ctzll(bits);
+        Thread *thread = levels[priority].steal(ticket);
+        if (thread != nullptr) {
+            return thread;
+        }
+        // emptied by thieves - no one else pushes, so it stays empty
+        non_empty_levels.fetch_and(~((uint64_t)1 << priority));
+    }
+}
+
+/*
+ * This function takes the first thread of the most urgent level, and the
+ * ticket it was pushed with - nullptr if the queue is empty. Any worker may
+ * call it.
+ */
+Thread *RunQueue::steal(unsigned long *ticket) {
+    uint64_t bits = non_empty_levels.load();
+    while (bits != 0) {
+        int priority = __builtin_ctzll(bits);
+        Thread *thread = levels[priority].steal(ticket);
+        if (thread != nullptr) {
+            return thread;
+        }
+        bits &= bits - 1;
+    }
+    return nullptr;
+}
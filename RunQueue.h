@@ -0,0 +1,41 @@
+//
+// Created by tetrukavi on 02/05/2021.
+//
+
+#ifndef OS_EX2_RUNQUEUE_H
+#define OS_EX2_RUNQUEUE_H
+
+#include <atomic>
+#include <cstdint>
+#include "Thread.h"
+#include "ThreadDeque.h"
+
+
+/*
+ * This class is the ready queue of a worker: a work-stealing deque per
+ * priority level, and a bitmap of the levels that may have threads, so the
+ * most urgent thread is found with one find-first-set. Only the owner
+ * pushes, so only the owner clears bits - of the levels it finds empty.
+ */
+class RunQueue {
+
+private:
+
+    ThreadDeque levels[PRIORITY_LEVELS]; // 0 is the most urgent
+    std::atomic<uint64_t> non_empty_levels{0};
+
+
+public:
+
+    bool empty() const;
+    long size() const;
+    int most_urgent_priority() const;
+    void push(Thread *thread, int priority);
+    Thread *pop(unsigned long *ticket);
+    Thread *steal(unsigned long *ticket);
+
+};
+
+
+
+#endif //OS_EX2_RUNQUEUE_H
@@ -0,0 +1,25 @@
+//
+// Created by tetrukavi on 02/05/2021.
+//
+
+#include "SchedulerPolicy.h"
+#include <cmath>
+
+
+int FairPolicy::weights[PRIORITY_LEVELS];
+unsigned long FairPolicy::sleeper_credit;
+unsigned long FairPolicy::wakeup_granularity;
+
+
+/*
+ * This function sets the weights of the priorities, and the sleeper credit
+ * and wakeup granularity by the length of a quantum
+ */
+void FairPolicy::configure(long quantum_ns) {
+    for (int priority = 0; priority < PRIORITY_LEVELS; priority++) {
+        double weight = DEFAULT_WEIGHT * pow(1.25, DEFAULT_PRIORITY - priority);
+        weights[priority] = std::max(1, (int)std::min(weight, 1e9));
+    }
+    sleeper_credit = (unsigned long)quantum_ns / 2;
+    wakeup_granularity = (unsigned long)quantum_ns / 4;
+}
@@ -0,0 +1,268 @@
+//
+// Created by tetrukavi on 02/05/2021.
+//
+
+#ifndef OS_EX2_SCHEDULERPOLICY_H
+#define OS_EX2_SCHEDULERPOLICY_H
+
+#include <algorithm>
+#include "Thread.h"
+#include "Worker.h"
+
+
+/*
+ * Scheduling policies - they order the ready threads of every worker (the
+ * periodic threads are scheduled before them by the library, see
+ * uthread_spawn_periodic). A policy is a class of static hooks, which the
+ * library calls in its critical section (steal, and pick_next of an idle
+ * worker, are called outside it, unless locked_steal()):
+ *
+ *   id()                                - the UTHREAD_POLICY_* value that selects it
+ *   locked_steal()                      - true if steal and pick_next must be called in the critical section
+ *   measures_run_time()                 - true if on_tick / on_block need the run times
+ *   configure(quantum_ns)               - at uthread_init
+ *   on_wake(worker, thread)             - thread becomes ready after a wait (or is new)
+ *   enqueue(worker, thread)             - thread joins the ready queue of worker
+ *   pick_next(worker, ticket)           - takes the next thread of worker, nullptr if none
+ *   queued(worker)                      - the number of threads in the ready queue of worker
+ *   steal(victim, thief, ticket)        - takes a thread of victim for thief, nullptr if none
+ *   should_preempt(woken, running)      - true if woken (just made ready) should run at once
+ *   should_yield(worker, running)       - true if a ready thread of worker should replace running
+ *   on_tick(thread, run_time)           - thread ran run_time ns and stays runnable
+ *   on_block(thread, run_time)          - thread ran run_time ns and now waits
+ *
+ * The hooks are defined here, in the header, so they inline into the switch
+ * path - with -DUTHREADS_POLICY=<class> the library is built for that policy
+ * alone, and otherwise it picks one at run time by options->policy (a switch,
+ * never an indirect call).
+ */
+
+
+/*
+ * This class is round robin - one FIFO queue per worker, the priorities are
+ * ignored.
+ */
+class RoundRobinPolicy {
+
+public:
+
+    static int id() {
+        return UTHREAD_POLICY_ROUND_ROBIN;
+    }
+
+    static bool locked_steal() {
+        return false;
+    }
+
+    static bool measures_run_time() {
+        return false;
+    }
+
+    static void configure(long quantum_ns) {
+        (void)quantum_ns;
+    }
+
+    static void on_wake(Worker &worker, Thread *thread) {
+        (void)worker;
+        (void)thread;
+    }
+
+    static void enqueue(Worker &worker, Thread *thread) {
+        worker.get_ready_threads().push(thread, DEFAULT_PRIORITY);
+    }
+
+    static Thread *pick_next(Worker &worker, unsigned long *ticket) {
+        return worker.get_ready_threads().pop(ticket);
+    }
+
+    static long queued(Worker &worker) {
+        return worker.get_ready_threads().size();
+    }
+
+    static Thread *steal(Worker &victim, Worker &thief, unsigned long *ticket) {
+        (void)thief;
+        return victim.get_ready_threads().steal(ticket);
+    }
+
+    static bool should_preempt(const Thread *woken, const Thread *running) {
+        (void)woken;
+        (void)running;
+        return false;
+    }
+
+    static bool should_yield(Worker &worker, const Thread *running) {
+        (void)worker;
+        (void)running;
+        return false;
+    }
+
+    static void on_tick(Thread *thread, unsigned long run_time) {
+        (void)thread;
+        (void)run_time;
+    }
+
+    static void on_block(Thread *thread, unsigned long run_time) {
+        (void)thread;
+        (void)run_time;
+    }
+
+};
+
+
+/*
+ * This class is strict priorities - the most urgent ready thread runs, and
+ * threads of the same priority run in round robin. A thread made ready with
+ * a more urgent priority than the running thread preempts it.
+ */
+class PriorityPolicy {
+
+public:
+
+    static int id() {
+        return UTHREAD_POLICY_PRIORITY;
+    }
+
+    static bool locked_steal() {
+        return false;
+    }
+
+    static bool measures_run_time() {
+        return false;
+    }
+
+    static void configure(long quantum_ns) {
+        (void)quantum_ns;
+    }
+
+    static void on_wake(Worker &worker, Thread *thread) {
+        (void)worker;
+        (void)thread;
+    }
+
+    static void enqueue(Worker &worker, Thread *thread) {
+        worker.get_ready_threads().push(thread, thread->get_priority());
+    }
+
+    static Thread *pick_next(Worker &worker, unsigned long *ticket) {
+        return worker.get_ready_threads().pop(ticket);
+    }
+
+    static long queued(Worker &worker) {
+        return worker.get_ready_threads().size();
+    }
+
+    static Thread *steal(Worker &victim, Worker &thief, unsigned long *ticket) {
+        (void)thief;
+        return victim.get_ready_threads().steal(ticket);
+    }
+
+    static bool should_preempt(const Thread *woken, const Thread *running) {
+        return woken->get_priority() < running->get_priority();
+    }
+
+    static bool should_yield(Worker &worker, const Thread *running) {
+        return worker.get_ready_threads().most_urgent_priority() < running->get_priority();
+    }
+
+    static void on_tick(Thread *thread, unsigned long run_time) {
+        (void)thread;
+        (void)run_time;
+    }
+
+    static void on_block(Thread *thread, unsigned long run_time) {
+        (void)thread;
+        (void)run_time;
+    }
+
+};
+
+
+/*
+ * This class is fair scheduling - the ready thread with the smallest virtual
+ * runtime (its run time scaled by the weight of its priority) runs. A thread
+ * that waited is placed at most sleeper_credit behind the queue, and
+ * preempts the running thread if it is behind it by wakeup_granularity.
+ */
+class FairPolicy {
+
+private:
+
+    static int weights[PRIORITY_LEVELS]; // DEFAULT_WEIGHT * 1.25 ^ (DEFAULT_PRIORITY - priority)
+    static unsigned long sleeper_credit; // ns
+    static unsigned long wakeup_granularity; // ns
+
+    static void charge(Thread *thread, unsigned long run_time) {
+        thread->set_vruntime(thread->get_vruntime() + run_time * DEFAULT_WEIGHT / weights[thread->get_priority()]);
+    }
+
+
+public:
+
+    static int id() {
+        return UTHREAD_POLICY_FAIR;
+    }
+
+    static bool locked_steal() {
+        return true;
+    }
+
+    static bool measures_run_time() {
+        return true;
+    }
+
+    static void configure(long quantum_ns);
+
+    static void on_wake(Worker &worker, Thread *thread) {
+        unsigned long min_vruntime = worker.get_fair_threads().get_min_vruntime();
+        if (min_vruntime > sleeper_credit) {
+            thread->set_vruntime(std::max(thread->get_vruntime(), min_vruntime - sleeper_credit));
+        }
+    }
+
+    static void enqueue(Worker &worker, Thread *thread) {
+        worker.get_fair_threads().push(thread);
+    }
+
+    static Thread *pick_next(Worker &worker, unsigned long *ticket) {
+        return worker.get_fair_threads().pop(ticket);
+    }
+
+    static long queued(Worker &worker) {
+        return worker.get_fair_threads().size();
+    }
+
+    // the virtual runtime of the thread moves from the scale of the victim's
+    // queue to the one of the thief's
+    static Thread *steal(Worker &victim, Worker &thief, unsigned long *ticket) {
+        FairRunQueue &queue = victim.get_fair_threads();
+        Thread *stolen = queue.pop(ticket);
+        if ((stolen != nullptr) && (*ticket == stolen->get_ready_ticket())) {
+            unsigned long lag = std::max(stolen->get_vruntime(), queue.get_min_vruntime()) - queue.get_min_vruntime();
+            stolen->set_vruntime(thief.get_fair_threads().get_min_vruntime() + lag);
+        }
+        return stolen;
+    }
+
+    static bool should_preempt(const Thread *woken, const Thread *running) {
+        return woken->get_vruntime() + wakeup_granularity < running->get_vruntime();
+    }
+
+    static bool should_yield(Worker &worker, const Thread *running) {
+        (void)worker;
+        (void)running;
+        return false;
+    }
+
+    static void on_tick(Thread *thread, unsigned long run_time) {
+        charge(thread, run_time);
+    }
+
+    static void on_block(Thread *thread, unsigned long run_time) {
+        charge(thread, run_time);
+    }
+
+};
+
+
+
+#endif //OS_EX2_SCHEDULERPOLICY_H
@@ -0,0 +1,51 @@
+//
+// Created by tetrukavi on 02/05/2021.
+//
+
+#include "Semaphore.h"
+
+
+/*
+ * This is the constructor of the semaphore
+ */
+Semaphore::Semaphore(int initial_value) : value(initial_value) {
+}
+
+/*
+ * This function returns the number of units available
+ */
+int Semaphore::get_value() const {
+    return value;
+}
+
+/*
+ * This function returns the queue of the threads that wait for a unit
+ */
+ThreadQueue &Semaphore::get_waiters() {
+    return waiters;
+}
+
+/*
+ * This function takes a unit, if one is available. It returns true if it
+ * did
+ */
+bool Semaphore::try_acquire() {
+    if (value == 0) {
+        return false;
+    }
+    value--;
+    return true;
+}
+
+/*
+ * This function gives back a unit - it returns the first waiting thread,
+ * which gets the unit (and is no longer in the queue), or nullptr if no
+ * thread waits and the unit became available
+ */
+Thread *Semaphore::release() {
+    if (!waiters.empty()) {
+        return waiters.pop_front();
+    }
+    value++;
+    return nullptr;
+}
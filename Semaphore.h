@@ -0,0 +1,38 @@
+//
+// Created by tetrukavi on 02/05/2021.
+//
+
+#ifndef OS_EX2_SEMAPHORE_H
+#define OS_EX2_SEMAPHORE_H
+
+#include "Thread.h"
+#include "ThreadQueue.h"
+
+
+/*
+ * This class represents a counting semaphore - its count and the threads
+ * that wait for it. A post while threads wait hands the unit directly to the
+ * first of them, so the count never rises while there are waiters.
+ */
+class Semaphore {
+
+private:
+
+    int value; // units available to the next waits
+    ThreadQueue waiters; // the threads that wait for a unit -> first in first out
+
+
+public:
+
+    explicit Semaphore(int initial_value);
+
+    int get_value() const;
+    ThreadQueue &get_waiters();
+    bool try_acquire();
+    Thread *release();
+
+};
+
+
+
+#endif //OS_EX2_SEMAPHORE_H
@@ -4,15 +4,22 @@
 
 
 #include "Thread.h"
+#include "Reservation.h"
 #include <setjmp.h>
 #include <signal.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#include <iostream>
+#include <map>
+#include <vector>
 
 
 
+#ifndef UTHREADS_ASM_SWITCH
+
 #ifdef __x86_64__
 /* code for 64 bit Intel arch */
 
-typedef unsigned long address_t;
 #define JB_SP 6
 #define JB_PC 7
 
@@ -31,7 +38,6 @@ address_t translate_address(address_t addr)
 #else
 /* code for 32 bit Intel arch */
 
-typedef unsigned int address_t;
 #define JB_SP 4
 #define JB_PC 5
 
@@ -49,23 +55,243 @@ address_t translate_address(address_t addr)
 
 #endif
 
+#else
+/* assembly context switch for 64 bit Intel arch */
 
+extern "C" {
+void uthread_switch_context(void **save_sp, void *load_sp);
+[[noreturn]] void uthread_load_context(void *load_sp);
+void uthread_context_start();
+}
 
+/*
+ * uthread_switch_context pushes the callee-saved registers (and the SSE/x87
+ * control words) on the current stack, stores the stack pointer in *save_sp
+ * and pops the same frame from load_sp. uthread_load_context only does the
+ * second half. A new thread starts in uthread_context_start, which calls
+ * r12 = thread_entry.
+ */
+asm(".pushsection .text\n"
+    ".globl uthread_switch_context\n"
+    ".type uthread_switch_context, @function\n"
+    "uthread_switch_context:\n"
+    "    pushq %rbp\n"
+    "    pushq %rbx\n"
+    "    pushq %r12\n"
+    "    pushq %r13\n"
+    "    pushq %r14\n"
+    "    pushq %r15\n"
+    "    subq $8, %rsp\n"
+    "    stmxcsr (%rsp)\n"
+    "    fnstcw 4(%rsp)\n"
+    "    movq %rsp, (%rdi)\n"
+    "    movq %rsi, %rsp\n"
+    "    jmp .Luthread_restore\n"
+    ".size uthread_switch_context, .-uthread_switch_context\n"
+    ".globl uthread_load_context\n"
+    ".type uthread_load_context, @function\n"
+    "uthread_load_context:\n"
+    "    movq %rdi, %rsp\n"
+    ".Luthread_restore:\n"
+    "    ldmxcsr (%rsp)\n"
+    "    fldcw 4(%rsp)\n"
+    "    addq $8, %rsp\n"
+    "    popq %r15\n"
+    "    popq %r14\n"
+    "    popq %r13\n"
+    "    popq %r12\n"
+    "    popq %rbx\n"
+    "    popq %rbp\n"
+    "    ret\n"
+    ".size uthread_load_context, .-uthread_load_context\n"
+    ".globl uthread_context_start\n"
+    ".type uthread_context_start, @function\n"
+    "uthread_context_start:\n"
+    "    callq *%r12\n"
+    "    ud2\n"
+    ".size uthread_context_start, .-uthread_context_start\n"
+    ".popsection\n");
+
+#endif
 
 
+
+
+int guarded_stacks = 0; // number of stacks that have a guard page
+// stack mappings without a guard page whose threads were deleted, by size -
+// kept mapped (without their pages) for the next threads, see ~Thread
+std::map<int, std::vector<char *>> spare_stacks;
+
 /*
- * This is the constructor of the thread object
+ * This function returns the size of a memory page
  */
-Thread::Thread(int id, void (*f)(void)) {
-    tid = id;
+address_t get_page_size() {
+    static address_t page_size = (address_t)sysconf(_SC_PAGESIZE);
+    return page_size;
+}
 
+/*
+ * This function returns the size of the stack mapping for a requested stack
+ * size - rounded up to whole pages
+ */
+int round_stack_size(int stack_size) {
+    address_t page_size = get_page_size();
+    return (int)(((address_t)stack_size + page_size - 1) & ~(page_size - 1));
+}
+
+/*
+ * This is the constructor of the thread object. The main thread runs on the
+ * process stack and is created with stack_size 0.
+ * The stack is an anonymous mapping (rounded up to whole pages) with a
+ * PROT_NONE guard page below it, so pages are only committed when they are
+ * touched and an overflow faults instead of corrupting other memory.
+ * With tens of thousands of threads (see MAX_GUARDED_STACKS) new stacks get
+ * no guard page, and the page below the stack stays accessible - they reuse
+ * the spare stacks of deleted threads first.
+ * If the stack can't be mapped, the thread is created without one (its
+ * stack size is 0) - see ThreadPool::acquire.
+ */
+Thread::Thread(int id, void (*f)(void), int stack_size) {
+    stack = nullptr;
+    this->stack_size = 0;
+    if (stack_size != 0) {
+        address_t page_size = get_page_size();
+        stack_size = round_stack_size(stack_size);
+        std::vector<char *> &spares = spare_stacks[stack_size];
+        if ((guarded_stacks >= MAX_GUARDED_STACKS) && !spares.empty()) {
+            stack = spares.back();
+            spares.pop_back();
+            this->stack_size = stack_size;
+            reset(id, f);
+            return;
+        }
+        void *mapping = mmap(nullptr, stack_size + page_size, PROT_READ | PROT_WRITE,
+                             MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE | MAP_STACK, -1, 0);
+        if (mapping == MAP_FAILED) {
+            reset(id, f);
+            return;
+        }
+        // each guard page splits the mapping, and the process may only have
+        // vm.max_map_count (65530 by default) mappings - so past
+        // MAX_GUARDED_STACKS the stacks are left without a guard page
+        if ((guarded_stacks < MAX_GUARDED_STACKS) && (mprotect(mapping, page_size, PROT_NONE) == 0)) {
+            has_guard_page = true;
+            guarded_stacks++;
+        }
+        stack = (char *)mapping + page_size;
+        this->stack_size = stack_size;
+    }
+    reset(id, f);
+}
+
+/*
+ * This function makes the thread new again - with the given id and entry
+ * point, no quantums, and a context that starts at thread_entry on an empty
+ * stack. It lets a terminated thread object (and its stack) be reused.
+ */
+void Thread::reset(int id, void (*f)(void)) {
+    tid = id;
+    entry = f;
+    my_state = 0;
+    blocked_by_thread = false;
+    blocked_by_mutex = false;
+    blocked_by_sync = false;
+    waiting_release = false;
+    wake_time = 0;
+    detached = true;
+    result = nullptr;
+    joiner = nullptr;
+    joining = nullptr;
+    join_result = nullptr;
+    start_routine = nullptr;
+    arg = nullptr;
+    held_mutexes = nullptr;
+    held_rwlocks_num = 0;
+    delete reservation;
+    reservation = nullptr;
+    priority = DEFAULT_PRIORITY;
+    quantum_usecs = 0;
+    ready_time = 0;
+    quantum_running_time = 0;
+    run_time = 0;
+    vruntime = 0;
+    if (stack == nullptr) {
+        return; // the context is saved on the first switch
+    }
+
+#ifndef UTHREADS_ASM_SWITCH
     address_t sp, pc;
-    sp = (address_t)stack + STACK_SIZE - sizeof(address_t);
-    pc = (address_t)f;
+    sp = (address_t)stack + stack_size - sizeof(address_t);
+    pc = (address_t)&thread_entry;
     sigsetjmp(env[0], 1);
     (env[0]->__jmpbuf)[JB_SP] = translate_address(sp);
     (env[0]->__jmpbuf)[JB_PC] = translate_address(pc);
     sigemptyset(&env[0]->__saved_mask);
+#else
+    // initial frame popped by uthread_load_context / uthread_switch_context:
+    // control words, r15, r14, r13, r12 = thread_entry, rbx, rbp, return address
+    auto *top = (address_t *)(((address_t)stack + stack_size) & ~(address_t)15);
+    address_t *frame = top - 8;
+    unsigned int control_words[2];
+    asm volatile("stmxcsr %0\n"
+                 "fnstcw %1\n"
+    : "=m" (control_words[0]), "=m" (control_words[1]));
+    frame[0] = (address_t)control_words[0] | ((address_t)(control_words[1] & 0xffff) << 32);
+    frame[1] = 0;
+    frame[2] = 0;
+    frame[3] = 0;
+    frame[4] = (address_t)&thread_entry;
+    frame[5] = 0;
+    frame[6] = 0;
+    frame[7] = (address_t)&uthread_context_start;
+    context_sp = frame;
+#endif
+}
+
+/*
+ * This is the destructor of the thread object
+ */
+Thread::~Thread() {
+    delete reservation;
+    if (stack == nullptr) {
+        return;
+    }
+    if (has_guard_page) {
+        munmap(stack - get_page_size(), stack_size + get_page_size());
+        guarded_stacks--;
+        return;
+    }
+    // stacks without a guard page sit next to each other in merged mappings,
+    // and unmapping one splits its mapping - which soon runs into
+    // vm.max_map_count with a million threads. So it stays mapped, without
+    // its memory, until another thread takes it
+    madvise(stack - get_page_size(), stack_size + get_page_size(), MADV_DONTNEED);
+    spare_stacks[stack_size].push_back(stack);
+}
+
+/*
+ * This function saves the context of this (running) thread and resumes next.
+ * It returns when some other thread switches back to this one.
+ */
+void Thread::switch_to(Thread *next) {
+#ifndef UTHREADS_ASM_SWITCH
+    if (sigsetjmp(env[0], 1) == 0) {
+        siglongjmp(next->env[0], 1);
+    }
+#else
+    uthread_switch_context(&context_sp, next->context_sp);
+#endif
+}
+
+/*
+ * This function resumes this thread without saving the current context.
+ */
+void Thread::resume_context() {
+#ifndef UTHREADS_ASM_SWITCH
+    siglongjmp(env[0], 1);
+#else
+    uthread_load_context(context_sp);
+#endif
 }
 
 /*
@@ -81,6 +307,53 @@ int Thread::get_state() const {
 int Thread::get_tid() const {
     return tid;
 }
+/*
+ * This function returns true if addr is in the guard page below the stack
+ */
+bool Thread::in_guard_page(const void *addr) const {
+    auto address = (address_t)addr;
+    return has_guard_page && (address < (address_t)stack) &&
+           (address >= (address_t)stack - get_page_size());
+}
+
+/*
+ * This function returns true if the stack has a guard page below it
+ */
+bool Thread::get_has_guard_page() const {
+    return has_guard_page;
+}
+
+/*
+ * This function returns the size of the thread's stack (0 for the main thread)
+ */
+int Thread::get_stack_size() const {
+    return stack_size;
+}
+
+/*
+ * This function returns the entry point of the thread
+ */
+entry_point_t Thread::get_entry() const {
+    return entry;
+}
+
+/*
+ * This function returns the entry point of a thread that takes an argument
+ * (see uthread_spawn_arg), nullptr for the other threads
+ */
+start_routine_t Thread::get_start_routine() const {
+    return start_routine;
+}
+
+void *Thread::get_arg() const {
+    return arg;
+}
+
+void Thread::set_start_routine(start_routine_t routine, void *routine_arg) {
+    start_routine = routine;
+    arg = routine_arg;
+}
+
 /*
  * This function returns true if the thread is blocked, false otherwise
  */
@@ -95,6 +368,44 @@ int Thread::get_quantum_running_time() const {
     return quantum_running_time;
 }
 
+/*
+ * This function gets the CPU time this thread ran, in nanoseconds
+ */
+unsigned long Thread::get_run_time() const {
+    return run_time;
+}
+
+/*
+ * This function gets the virtual runtime of this thread - its run time
+ * scaled by the weight of its priority (fair scheduling)
+ */
+unsigned long Thread::get_vruntime() const {
+    return vruntime;
+}
+
+void Thread::set_vruntime(unsigned long new_vruntime) {
+    vruntime = new_vruntime;
+}
+
+/*
+ * This function adds run_time_ns to the run time of this thread
+ */
+void Thread::add_run_time(unsigned long run_time_ns) {
+    run_time += run_time_ns;
+}
+
+/*
+ * This function gets the time the thread last became ready (CLOCK_MONOTONIC
+ * nanoseconds), 0 if it isn't measured
+ */
+unsigned long Thread::get_ready_time() const {
+    return ready_time;
+}
+
+void Thread::set_ready_time(unsigned long time_ns) {
+    ready_time = time_ns;
+}
+
 
 
 /*
@@ -127,7 +438,256 @@ void Thread::set_blocked_by_mutex(bool mutex_status) {
 
 }
 
+/*
+ * This function returns true if this periodic thread waits for the start of
+ * its next period
+ */
+bool Thread::get_waiting_release() const {
+    return waiting_release;
+}
+
+void Thread::set_waiting_release(bool is_waiting) {
+    waiting_release = is_waiting;
+}
+
+/*
+ * This function returns true if the thread waits on a semaphore, barrier,
+ * latch or wait group
+ */
+bool Thread::get_blocked_by_sync() const {
+    return blocked_by_sync;
+}
+
+void Thread::set_blocked_by_sync(bool sync_status) {
+    blocked_by_sync = sync_status;
+}
+
+/*
+ * This function returns when this sleeping thread wakes up (monotonic ns),
+ * 0 if it doesn't sleep
+ */
+unsigned long Thread::get_wake_time() const {
+    return wake_time;
+}
+
+void Thread::set_wake_time(unsigned long time_ns) {
+    wake_time = time_ns;
+}
+
+/*
+ * This function returns true if the thread is freed when it terminates,
+ * false if it is kept until it is joined
+ */
+bool Thread::get_detached() const {
+    return detached;
+}
+
+void Thread::set_detached(bool is_detached) {
+    detached = is_detached;
+}
+
+/*
+ * This function returns what the terminated joinable thread returned
+ */
+void *Thread::get_result() const {
+    return result;
+}
+
+void Thread::set_result(void *thread_result) {
+    result = thread_result;
+}
+
+/*
+ * This function returns the thread that waits to join this one, nullptr if
+ * there is none
+ */
+Thread *Thread::get_joiner() const {
+    return joiner;
+}
+
+void Thread::set_joiner(Thread *thread) {
+    joiner = thread;
+}
+
+/*
+ * This function returns the thread this one waits to join, nullptr if it
+ * doesn't wait
+ */
+Thread *Thread::get_joining() const {
+    return joining;
+}
+
+/*
+ * This function sets the thread this one waits to join, and where the
+ * joined thread's result goes (may be nullptr)
+ */
+void Thread::set_joining(Thread *thread, void **result_ptr) {
+    joining = thread;
+    join_result = result_ptr;
+}
 
+void **Thread::get_join_result() const {
+    return join_result;
+}
 
+/*
+ * This function returns the reservation of this periodic thread, nullptr
+ * for the other threads
+ */
+Reservation *Thread::get_reservation() const {
+    return reservation;
+}
 
+/*
+ * This function sets the reservation of the thread - the thread owns it
+ */
+void Thread::set_reservation(Reservation *new_reservation) {
+    reservation = new_reservation;
+}
 
+/*
+ * This function returns the first of the mutexes this thread holds
+ */
+Mutex *Thread::get_held_mutexes() const {
+    return held_mutexes;
+}
+
+/*
+ * This function sets the first of the mutexes this thread holds
+ */
+void Thread::set_held_mutexes(Mutex *mutexes) {
+    held_mutexes = mutexes;
+}
+
+/*
+ * This function returns true if this thread holds the reader-writer lock
+ * (for reading or for writing)
+ */
+bool Thread::holds_rwlock(const RWLock *rwlock) const {
+    for (int i = 0; i < held_rwlocks_num; i++) {
+        if (held_rwlocks[i].rwlock == rwlock) {
+            return true;
+        }
+    }
+    return false;
+}
+
+/*
+ * This function returns true if this thread may take the reader-writer
+ * lock - it holds it already, or holds fewer than MAX_HELD_RWLOCKS locks
+ */
+bool Thread::can_hold_rwlock(const RWLock *rwlock) const {
+    return (held_rwlocks_num < MAX_HELD_RWLOCKS) || holds_rwlock(rwlock);
+}
+
+/*
+ * This function returns the reader-writer lock this thread took last, of
+ * those it holds - nullptr if it holds none
+ */
+RWLock *Thread::get_held_rwlock() const {
+    return (held_rwlocks_num == 0) ? nullptr : held_rwlocks[held_rwlocks_num - 1].rwlock;
+}
+
+/*
+ * This function records a hold of the reader-writer lock by this thread,
+ * which may take it (see can_hold_rwlock)
+ */
+void Thread::add_held_rwlock(RWLock *rwlock) {
+    for (int i = 0; i < held_rwlocks_num; i++) {
+        if (held_rwlocks[i].rwlock == rwlock) {
+            held_rwlocks[i].holds++;
+            return;
+        }
+    }
+    held_rwlocks[held_rwlocks_num].rwlock = rwlock;
+    held_rwlocks[held_rwlocks_num].holds = 1;
+    held_rwlocks_num++;
+}
+
+/*
+ * This function removes a hold of the reader-writer lock by this thread.
+ * It returns false if this thread doesn't hold it
+ */
+bool Thread::remove_held_rwlock(RWLock *rwlock) {
+    for (int i = 0; i < held_rwlocks_num; i++) {
+        if (held_rwlocks[i].rwlock != rwlock) {
+            continue;
+        }
+        if (--held_rwlocks[i].holds == 0) {
+            held_rwlocks_num--;
+            for (int j = i; j < held_rwlocks_num; j++) {
+                held_rwlocks[j] = held_rwlocks[j + 1];
+            }
+        }
+        return true;
+    }
+    return false;
+}
+
+/*
+ * This function returns the queue this thread is in (the ready queue or a
+ * wait queue), nullptr if it is in none
+ */
+ThreadQueue *Thread::get_queue() const {
+    return queue;
+}
+
+/*
+ * This function returns the priority of the thread - 0 is the most urgent
+ */
+int Thread::get_priority() const {
+    return priority;
+}
+
+void Thread::set_priority(int priority) {
+    this->priority = priority;
+}
+
+/*
+ * This function returns the quantum of the thread in microseconds, 0 if it
+ * runs with the quantum of the library
+ */
+int Thread::get_quantum_usecs() const {
+    return quantum_usecs;
+}
+
+void Thread::set_quantum_usecs(int quantum_usecs) {
+    this->quantum_usecs = quantum_usecs;
+}
+
+/*
+ * This function returns the index of the worker the thread runs (or last ran) on
+ */
+int Thread::get_worker() const {
+    return worker;
+}
+
+void Thread::set_worker(int worker) {
+    this->worker = worker;
+}
+
+/*
+ * This function returns the number of entries of the thread in the ready deques
+ */
+int Thread::get_ready_entries() const {
+    return ready_entries;
+}
+
+void Thread::set_ready_entries(int entries) {
+    ready_entries = entries;
+}
+
+/*
+ * This function returns the ticket of the valid entry of the thread in the
+ * ready deques - an entry with another ticket is skipped when it is taken
+ */
+unsigned long Thread::get_ready_ticket() const {
+    return ready_ticket;
+}
+
+/*
+ * This function invalidates the entries of the thread in the ready deques
+ */
+void Thread::next_ready_ticket() {
+    ready_ticket++;
+}
@@ -10,6 +10,43 @@
 #include "uthreads.h"
 
 typedef unsigned long address_t;
+typedef void (*entry_point_t)(void);
+typedef void *(*start_routine_t)(void *);
+
+#ifndef MAX_GUARDED_STACKS
+#define MAX_GUARDED_STACKS 16384 /* stacks beyond this many get no guard page */
+#endif
+
+#define DEFAULT_WEIGHT 1024 /* fair scheduling weight of DEFAULT_PRIORITY - its vruntime is its run time (see SchedulerPolicy.h) */
+
+/*
+ * Context switch backend. By default threads are switched with
+ * sigsetjmp/siglongjmp, which also saves and restores each thread's signal
+ * mask. On x86-64, building with -DUTHREADS_ASM_SWITCH selects the
+ * hand-written routine in Thread.cpp instead, which saves only the
+ * callee-saved registers and the stack pointer (signal masks are then shared
+ * by all threads).
+ */
+#if defined(UTHREADS_ASM_SWITCH) && !defined(__x86_64__)
+#undef UTHREADS_ASM_SWITCH
+#endif
+
+/*
+ * First function that runs on every spawned thread's stack - it leaves the
+ * library's critical section and calls the thread's entry point.
+ * Defined in uthreads.cpp.
+ */
+void thread_entry();
+
+class ThreadQueue;
+class Mutex;
+class RWLock;
+class Reservation;
+
+/*
+ * Size of the stack mapping for a requested stack size. Defined in Thread.cpp.
+ */
+int round_stack_size(int stack_size);
 
 
 /*
@@ -19,30 +56,128 @@ class Thread {
 
 private:
 
-    int my_state; // 1 - running, 2 - ready
+    int my_state = 0; // 1 - running, 2 - ready
     bool blocked_by_thread = false; // default not blocked
-    bool blocked_by_mutex = false;
+    bool blocked_by_mutex = false; // waits for a mutex (or on a condition variable, to get its mutex back)
+    bool blocked_by_sync = false; // waits on a semaphore, barrier, latch or wait group
+    bool waiting_release = false; // a periodic thread that waits for its next period
+    unsigned long wake_time = 0; // when the sleeping thread wakes up (monotonic ns), 0 if it doesn't sleep
+    bool detached = true; // freed when it terminates, or else kept (with its result) until it is joined
+    void *result = nullptr; // what the joinable thread returned (see uthread_join)
+    Thread *joiner = nullptr; // the thread that waits in uthread_join for this one
+    Thread *joining = nullptr; // the thread this one waits for in uthread_join
+    void **join_result = nullptr; // where the result of the joined thread goes
+    Mutex *held_mutexes = nullptr; // the mutexes this thread holds (see Mutex.h)
+    // the reader-writer locks this thread holds (see RWLock.h), in the order
+    // it took them, with the number of holds of each - a fixed array, so
+    // taking a lock doesn't allocate
+    struct {
+        RWLock *rwlock;
+        int holds;
+    } held_rwlocks[MAX_HELD_RWLOCKS];
+    int held_rwlocks_num = 0;
+    int priority = DEFAULT_PRIORITY; // 0 is the most urgent
+    int quantum_usecs = 0; // quantum of this thread, 0 - the library's (see uthread_set_quantum)
+    Reservation *reservation = nullptr; // of a periodic thread (see Reservation.h), owned by the thread
+    int worker = 0; // the worker the thread runs (or last ran) on (see Worker.h)
+    // entries of the thread in the ready deques, and the ticket of the one
+    // that is valid - the others were left behind when the thread stopped
+    // being ready (blocked, terminated, priority changed)
+    int ready_entries = 0;
+    unsigned long ready_ticket = 0;
+    unsigned long ready_time = 0; // when it last became ready (monotonic ns), 0 if not measured
     int quantum_running_time = 0; // total number of quantums of this thread
+    unsigned long run_time = 0; // CPU time the thread ran, in nanoseconds
+    unsigned long vruntime = 0; // run time scaled by the weight of the priority (fair scheduling)
     int tid;
+    entry_point_t entry; // the thread's function
+    start_routine_t start_routine = nullptr; // the thread's function, if it takes an argument (entry is nullptr)
+    void *arg = nullptr; // the argument of start_routine
+    int stack_size;
+    bool has_guard_page = false;
+
+    // links of the ThreadQueue this thread is in (see ThreadQueue.h)
+    ThreadQueue *queue = nullptr;
+    Thread *queue_prev = nullptr;
+    Thread *queue_next = nullptr;
+
+    friend class ThreadQueue;
 
 
 public:
 
 
-    Thread(int id, void (*f)(void));
+    Thread(int id, void (*f)(void), int stack_size);
+    ~Thread();
+
+    void reset(int id, void (*f)(void));
 
+#ifdef UTHREADS_ASM_SWITCH
+    void *context_sp = nullptr; // saved stack pointer while not running
+#else
     sigjmp_buf env[1];
-    char stack[STACK_SIZE]; // pointer of the stack - allocate in the heap
+#endif
+    char *stack; // pointer of the stack - mmap-ed (nullptr for the main thread)
 
     int get_state() const;
     bool get_blocked_by_thread() const;
     bool get_blocked_by_mutex() const;
     void set_blocked_by_mutex(bool mutex_status) ;
+    bool get_blocked_by_sync() const;
+    void set_blocked_by_sync(bool sync_status);
+    bool get_waiting_release() const;
+    void set_waiting_release(bool is_waiting);
+    unsigned long get_wake_time() const;
+    void set_wake_time(unsigned long time_ns);
+    bool get_detached() const;
+    void set_detached(bool is_detached);
+    void *get_result() const;
+    void set_result(void *thread_result);
+    Thread *get_joiner() const;
+    void set_joiner(Thread *thread);
+    Thread *get_joining() const;
+    void set_joining(Thread *thread, void **result_ptr);
+    void **get_join_result() const;
+    Reservation *get_reservation() const;
+    void set_reservation(Reservation *new_reservation);
+    Mutex *get_held_mutexes() const;
+    void set_held_mutexes(Mutex *mutexes);
+    bool holds_rwlock(const RWLock *rwlock) const;
+    bool can_hold_rwlock(const RWLock *rwlock) const;
+    RWLock *get_held_rwlock() const;
+    void add_held_rwlock(RWLock *rwlock);
+    bool remove_held_rwlock(RWLock *rwlock);
+    ThreadQueue *get_queue() const;
+    int get_priority() const;
+    void set_priority(int priority);
+    int get_quantum_usecs() const;
+    void set_quantum_usecs(int quantum_usecs);
+    int get_worker() const;
+    void set_worker(int worker);
+    int get_ready_entries() const;
+    void set_ready_entries(int entries);
+    unsigned long get_ready_ticket() const;
+    void next_ready_ticket();
+    unsigned long get_ready_time() const;
+    void set_ready_time(unsigned long time_ns);
     int get_quantum_running_time() const;
+    unsigned long get_run_time() const;
+    unsigned long get_vruntime() const;
+    void set_vruntime(unsigned long vruntime);
+    void add_run_time(unsigned long run_time_ns);
     int get_tid() const;
+    int get_stack_size() const;
+    bool in_guard_page(const void *addr) const;
+    bool get_has_guard_page() const;
+    entry_point_t get_entry() const;
+    start_routine_t get_start_routine() const;
+    void *get_arg() const;
+    void set_start_routine(start_routine_t routine, void *routine_arg);
     void set_state(int state);
     void set_blocked_by_thread(bool check_if_blocked);
     void set_quantum_running_time(int quantum_usecs);
+    void switch_to(Thread *next);
+    [[noreturn]] void resume_context();
 
 };
 
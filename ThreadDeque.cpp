@@ -0,0 +1,107 @@
+//
+// Created by tetrukavi on 02/05/2021.
+//
+
+#include "ThreadDeque.h"
+
+#define INITIAL_CAPACITY 64
+
+
+/*
+ * This is the constructor of the deque
+ */
+ThreadDeque::ThreadDeque() {
+    auto *first_ring = new Ring;
+    first_ring->capacity = INITIAL_CAPACITY;
+    first_ring->slots = new Slot[INITIAL_CAPACITY];
+    ring.store(first_ring, std::memory_order_relaxed);
+}
+
+/*
+ * This is the destructor of the deque
+ */
+ThreadDeque::~ThreadDeque() {
+    retired_rings.push_back(ring.load(std::memory_order_relaxed));
+    for (Ring *old_ring : retired_rings) {
+        delete[] old_ring->slots;
+        delete old_ring;
+    }
+}
+
+/*
+ * This function returns true if the deque has no threads
+ */
+bool ThreadDeque::empty() const {
+    return size() == 0;
+}
+
+/*
+ * This function returns the number of threads in the deque
+ */
+long ThreadDeque::size() const {
+    long size = bottom.load(std::memory_order_acquire) - top.load(std::memory_order_acquire);
+    return size > 0 ? size : 0;
+}
+
+/*
+ * This function copies the threads to a ring twice as large (owner only)
+ */
+ThreadDeque::Ring *ThreadDeque::grow(Ring *old_ring, long top_index, long bottom_index) {
+    auto *new_ring = new Ring;
+    new_ring->capacity = old_ring->capacity * 2;
+    new_ring->slots = new Slot[new_ring->capacity];
+    for (long i = top_index; i < bottom_index; i++) {
+        Slot &old_slot = old_ring->slots[i & (old_ring->capacity - 1)];
+        Slot &new_slot = new_ring->slots[i & (new_ring->capacity - 1)];
+        new_slot.thread.store(old_slot.thread.load(std::memory_order_relaxed), std::memory_order_relaxed);
+        new_slot.ticket.store(old_slot.ticket.load(std::memory_order_relaxed), std::memory_order_relaxed);
+    }
+    retired_rings.push_back(old_ring);
+    ring.store(new_ring, std::memory_order_release);
+    return new_ring;
+}
+
+/*
+ * This function pushes the thread, with its ready ticket, at the bottom of
+ * the deque (owner only)
+ */
+void ThreadDeque::push(Thread *thread, unsigned long ticket) {
+    long bottom_index = bottom.load(std::memory_order_relaxed);
+    long top_index = top.load(std::memory_order_acquire);
+    Ring *current = ring.load(std::memory_order_relaxed);
+    if (bottom_index - top_index >= current->capacity) {
+        current = grow(current, top_index, bottom_index);
+    }
+    Slot &slot = current->slots[bottom_index & (current->capacity - 1)];
+    slot.thread.store(thread, std::memory_order_relaxed);
+    slot.ticket.store(ticket, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    bottom.store(bottom_index + 1, std::memory_order_relaxed);
+}
+
+/*
+ * This function takes the thread at the top of the deque, and the ticket it
+ * was pushed with - nullptr if it is empty. Any worker may call it.
+ */
+Thread *ThreadDeque::steal(unsigned long *ticket) {
+    while (true) {
+        long top_index = top.load(std::memory_order_acquire);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        long bottom_index = bottom.load(std::memory_order_acquire);
+        if (top_index >= bottom_index) {
+            return nullptr;
+        }
+        Ring *current = ring.load(std::memory_order_acquire);
+        // the slot may be overwritten once another worker took it - then
+        // the CAS below fails, and what we read is dropped
+        Slot &slot = current->slots[top_index & (current->capacity - 1)];
+        Thread *thread = slot.thread.load(std::memory_order_relaxed);
+        unsigned long slot_ticket = slot.ticket.load(std::memory_order_relaxed);
+        if (top.compare_exchange_strong(top_index, top_index + 1,
+                                        std::memory_order_seq_cst, std::memory_order_relaxed)) {
+            *ticket = slot_ticket;
+            return thread;
+        }
+        // another worker took it first - try the next one
+    }
+}
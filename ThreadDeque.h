@@ -0,0 +1,61 @@
+//
+// Created by tetrukavi on 02/05/2021.
+//
+
+#ifndef OS_EX2_THREADDEQUE_H
+#define OS_EX2_THREADDEQUE_H
+
+#include <atomic>
+#include <vector>
+#include "Thread.h"
+
+
+/*
+ * This class is the work-stealing run queue of a worker - a lock-free
+ * Chase-Lev deque of threads. Only the owner pushes, at the bottom; the
+ * threads are taken from the top, by the owner and by the other workers
+ * (stealing) alike, so the owner still runs its threads in round robin
+ * order. The ring grows (doubling) when full, and the replaced rings are
+ * kept until the deque is destroyed, since a thief may still read them.
+ * Every entry carries the ready ticket the thread had when it was pushed,
+ * so an entry left behind by a thread that stopped being ready is known.
+ */
+class ThreadDeque {
+
+private:
+
+    struct Slot {
+        std::atomic<Thread*> thread;
+        std::atomic<unsigned long> ticket;
+    };
+
+    struct Ring {
+        long capacity; // a power of 2
+        Slot *slots;
+    };
+
+    std::atomic<long> top{0};
+    std::atomic<long> bottom{0};
+    std::atomic<Ring*> ring;
+    std::vector<Ring*> retired_rings;
+
+    Ring *grow(Ring *old_ring, long top_index, long bottom_index);
+
+
+public:
+
+    ThreadDeque();
+    ~ThreadDeque();
+    ThreadDeque(const ThreadDeque &) = delete;
+    ThreadDeque &operator=(const ThreadDeque &) = delete;
+
+    bool empty() const;
+    long size() const;
+    void push(Thread *thread, unsigned long ticket);
+    Thread *steal(unsigned long *ticket);
+
+};
+
+
+
+#endif //OS_EX2_THREADDEQUE_H
@@ -0,0 +1,93 @@
+//
+// Created by tetrukavi on 02/05/2021.
+//
+
+#include "ThreadPool.h"
+
+
+/*
+ * This is the constructor of the thread pool
+ */
+ThreadPool::ThreadPool(int max_threads) : max_threads(max_threads) {
+}
+
+/*
+ * This function returns a thread with the given id, entry point and stack
+ * size - a cached one if there is one, otherwise a new one (nullptr if its
+ * stack can't be mapped)
+ */
+Thread *ThreadPool::acquire(int id, void (*f)(void), int stack_size) {
+    auto it = free_threads.find(round_stack_size(stack_size));
+    if ((it != free_threads.end()) && !it->second.empty()) {
+        Thread *thread = it->second.pop_front();
+        cached--;
+        thread->reset(id, f);
+        return thread;
+    }
+    Thread *thread = new Thread(id, f, stack_size);
+    if ((stack_size != 0) && (thread->get_stack_size() == 0)) {
+        // its stack couldn't be mapped
+        delete thread;
+        return nullptr;
+    }
+    return thread;
+}
+
+/*
+ * This function takes a terminated thread - it is cached if there is room,
+ * otherwise deleted (and its stack unmapped)
+ */
+void ThreadPool::release(Thread *thread) {
+    if ((thread->get_stack_size() == 0) || (cached >= max_threads)) {
+        delete thread;
+        return;
+    }
+    free_threads[thread->get_stack_size()].push_back(thread);
+    cached++;
+}
+
+/*
+ * This function creates threads with the given stack size until the pool
+ * has count threads (or is full)
+ */
+void ThreadPool::reserve(int count, int stack_size) {
+    while ((cached < count) && (cached < max_threads)) {
+        Thread *thread = new Thread(-1, nullptr, stack_size);
+        if (thread->get_stack_size() == 0) {
+            // its stack couldn't be mapped
+            delete thread;
+            return;
+        }
+        release(thread);
+    }
+}
+
+/*
+ * This function sets the high-water mark of the pool, deleting cached
+ * threads above it
+ */
+void ThreadPool::set_max_threads(int max_threads) {
+    this->max_threads = max_threads;
+    for (auto &size_and_threads : free_threads) {
+        while ((cached > max_threads) && !size_and_threads.second.empty()) {
+            delete size_and_threads.second.pop_front();
+            cached--;
+        }
+    }
+}
+
+/*
+ * This function returns the number of cached threads
+ */
+int ThreadPool::size() const {
+    return cached;
+}
+
+/*
+ * This function deletes all the cached threads
+ */
+void ThreadPool::clear() {
+    int high_water_mark = max_threads;
+    set_max_threads(0);
+    max_threads = high_water_mark;
+}
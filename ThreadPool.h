@@ -0,0 +1,44 @@
+//
+// Created by tetrukavi on 02/05/2021.
+//
+
+#ifndef OS_EX2_THREADPOOL_H
+#define OS_EX2_THREADPOOL_H
+
+#include <map>
+#include "Thread.h"
+#include "ThreadQueue.h"
+
+
+/*
+ * This class caches terminated threads (the Thread object together with its
+ * stack) so spawning a thread reuses one instead of allocating a new object
+ * and mapping a new stack. Cached threads are kept per stack size, and at
+ * most max_threads of them are kept - beyond that they are deleted (a stack
+ * without a guard page stays mapped for the next thread, see ~Thread).
+ */
+class ThreadPool {
+
+private:
+
+    std::map<int, ThreadQueue> free_threads; // stack mapping size -> cached threads
+    int cached = 0;
+    int max_threads;
+
+
+public:
+
+    explicit ThreadPool(int max_threads);
+
+    Thread *acquire(int id, void (*f)(void), int stack_size);
+    void release(Thread *thread);
+    void reserve(int count, int stack_size);
+    void set_max_threads(int max_threads);
+    int size() const;
+    void clear();
+
+};
+
+
+
+#endif //OS_EX2_THREADPOOL_H
@@ -0,0 +1,115 @@
+//
+// Created by tetrukavi on 02/05/2021.
+//
+
+#include "ThreadQueue.h"
+
+
+/*
+ * This function returns true if there are no threads in the queue
+ */
+bool ThreadQueue::empty() const {
+    return head == nullptr;
+}
+
+/*
+ * This function returns the number of threads in the queue
+ */
+int ThreadQueue::size() const {
+    return length;
+}
+
+/*
+ * This function returns the first thread in the queue, nullptr if it is empty
+ */
+Thread *ThreadQueue::front() const {
+    return head;
+}
+
+/*
+ * This function returns true if the thread is in this queue
+ */
+bool ThreadQueue::contains(const Thread *thread) const {
+    return thread->queue == this;
+}
+
+/*
+ * This function returns the thread after the given one (which must be in
+ * the queue), nullptr if it is the last
+ */
+Thread *ThreadQueue::next(const Thread *thread) const {
+    return thread->queue_next;
+}
+
+/*
+ * This function adds the thread to the end of the queue
+ */
+void ThreadQueue::push_back(Thread *thread) {
+    thread->queue = this;
+    thread->queue_prev = tail;
+    thread->queue_next = nullptr;
+    if (tail != nullptr) {
+        tail->queue_next = thread;
+    }
+    else {
+        head = thread;
+    }
+    tail = thread;
+    length++;
+}
+
+/*
+ * This function adds the thread before position (which must be in the
+ * queue) - at the end of the queue if position is nullptr
+ */
+void ThreadQueue::insert_before(Thread *position, Thread *thread) {
+    if (position == nullptr) {
+        push_back(thread);
+        return;
+    }
+    thread->queue = this;
+    thread->queue_prev = position->queue_prev;
+    thread->queue_next = position;
+    if (position->queue_prev != nullptr) {
+        position->queue_prev->queue_next = thread;
+    }
+    else {
+        head = thread;
+    }
+    position->queue_prev = thread;
+    length++;
+}
+
+/*
+ * This function removes and returns the first thread in the queue,
+ * nullptr if it is empty
+ */
+Thread *ThreadQueue::pop_front() {
+    Thread *thread = head;
+    if (thread != nullptr) {
+        remove(thread);
+    }
+    return thread;
+}
+
+/*
+ * This function removes the thread from the queue (it must be in it)
+ */
+void ThreadQueue::remove(Thread *thread) {
+    if (thread->queue_prev != nullptr) {
+        thread->queue_prev->queue_next = thread->queue_next;
+    }
+    else {
+        head = thread->queue_next;
+    }
+    if (thread->queue_next != nullptr) {
+        thread->queue_next->queue_prev = thread->queue_prev;
+    }
+    else {
+        tail = thread->queue_prev;
+    }
+    thread->queue = nullptr;
+    thread->queue_prev = nullptr;
+    thread->queue_next = nullptr;
+    length--;
+}
@@ -0,0 +1,42 @@
+//
+// Created by tetrukavi on 02/05/2021.
+//
+
+#ifndef OS_EX2_THREADQUEUE_H
+#define OS_EX2_THREADQUEUE_H
+
+#include "Thread.h"
+
+
+/*
+ * This class represents a first in first out queue of threads (or one the
+ * caller keeps ordered, with insert_before). The queue is
+ * intrusive - the links live inside the Thread objects, so every operation
+ * is O(1) and never allocates. A thread is in at most one queue at a time.
+ */
+class ThreadQueue {
+
+private:
+
+    Thread *head = nullptr;
+    Thread *tail = nullptr;
+    int length = 0;
+
+
+public:
+
+    bool empty() const;
+    int size() const;
+    Thread *front() const;
+    Thread *next(const Thread *thread) const;
+    bool contains(const Thread *thread) const;
+    void push_back(Thread *thread);
+    void insert_before(Thread *position, Thread *thread);
+    Thread *pop_front();
+    void remove(Thread *thread);
+
+};
+
+
+
+#endif //OS_EX2_THREADQUEUE_H
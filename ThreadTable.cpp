@@ -0,0 +1,138 @@
+//
+// Created by tetrukavi on 02/05/2021.
+//
+
+#include "ThreadTable.h"
+
+#define INITIAL_CAPACITY 64
+#define WORD_BITS 64
+
+
+/*
+ * This is the constructor of the thread table
+ */
+ThreadTable::ThreadTable(int max_threads) : max_threads(max_threads) {
+}
+
+/*
+ * This function returns the thread with the given tid, nullptr if there is none
+ */
+Thread *ThreadTable::get(int tid) const {
+    if ((tid < 0) || (tid >= (int)threads.size())) {
+        return nullptr;
+    }
+    return threads[tid];
+}
+
+/*
+ * This function returns the number of tids the table currently has room for
+ */
+int ThreadTable::capacity() const {
+    return (int)threads.size();
+}
+
+/*
+ * This function sets the number of threads the table may hold (before any
+ * tid is allocated)
+ */
+void ThreadTable::set_max_threads(int max_threads) {
+    this->max_threads = max_threads;
+}
+
+/*
+ * This function returns the lowest free tid and marks it as used,
+ * -1 if there are already max_threads threads
+ */
+int ThreadTable::allocate_tid() {
+    if (free_levels.empty() || free_levels.back()[0] == 0) {
+        if (capacity() >= max_threads) {
+            return -1;
+        }
+        grow();
+    }
+
+    // go down from the top level, each word points to the first word below that has a free tid
+    int index = 0;
+    for (int level = (int)free_levels.size() - 1; level >= 0; level--) {
+        index = index * WORD_BITS + __builtin_ctzll(free_levels[level][index]);
+    }
+    set_used(index);
+    return index;
+}
+
+/*
+ * This function puts the thread in the table under its (allocated) tid
+ */
+void ThreadTable::insert(Thread *thread) {
+    threads[thread->get_tid()] = thread;
+}
+
+/*
+ * This function removes the thread with the given tid and frees the tid
+ */
+void ThreadTable::release(int tid) {
+    threads[tid] = nullptr;
+    set_free(tid);
+}
+
+/*
+ * This function doubles the capacity of the table (up to max_threads) and
+ * rebuilds the bitmap levels for the new capacity
+ */
+void ThreadTable::grow() {
+    int old_capacity = capacity();
+    int new_capacity = old_capacity == 0 ? INITIAL_CAPACITY : old_capacity * 2;
+    if (new_capacity > max_threads) {
+        new_capacity = max_threads;
+    }
+    threads.resize(new_capacity, nullptr);
+
+    std::vector<std::vector<uint64_t>> old_levels;
+    old_levels.swap(free_levels);
+    int bits = new_capacity;
+    do {
+        int words = (bits + WORD_BITS - 1) / WORD_BITS;
+        free_levels.emplace_back(words, 0);
+        bits = words;
+    } while (bits > 1);
+
+    // copy the old free bits, the new tids are all free
+    for (int tid = 0; tid < new_capacity; tid++) {
+        bool is_free = tid >= old_capacity ||
+                ((old_levels[0][tid / WORD_BITS] >> (tid % WORD_BITS)) & 1);
+        if (is_free) {
+            set_free(tid);
+        }
+    }
+}
+
+/*
+ * This function marks the tid as free in every level of the bitmap
+ */
+void ThreadTable::set_free(int tid) {
+    int index = tid;
+    for (auto &level : free_levels) {
+        uint64_t &word = level[index / WORD_BITS];
+        bool was_empty = word == 0;
+        word |= (uint64_t)1 << (index % WORD_BITS);
+        if (!was_empty) {
+            return; // the levels above already know this word has a free tid
+        }
+        index /= WORD_BITS;
+    }
+}
+
+/*
+ * This function marks the tid as used in every level of the bitmap
+ */
+void ThreadTable::set_used(int tid) {
+    int index = tid;
+    for (auto &level : free_levels) {
+        uint64_t &word = level[index / WORD_BITS];
+        word &= ~((uint64_t)1 << (index % WORD_BITS));
+        if (word != 0) {
+            return; // the word still has a free tid
+        }
+        index /= WORD_BITS;
+    }
+}
@@ -0,0 +1,49 @@
+//
+// Created by tetrukavi on 02/05/2021.
+//
+
+#ifndef OS_EX2_THREADTABLE_H
+#define OS_EX2_THREADTABLE_H
+
+#include <vector>
+#include <cstdint>
+#include "Thread.h"
+
+
+/*
+ * This class maps thread ids to threads. The table is indexed by tid and
+ * grows (doubling) up to max_threads. Free tids are tracked by a
+ * hierarchical bitmap - each bit of a level tells if the matching word of
+ * the level below has a free tid - so the lowest free tid is found with one
+ * find-first-set per level, and allocating / releasing a tid is O(1) even
+ * with millions of threads.
+ */
+class ThreadTable {
+
+private:
+
+    std::vector<Thread*> threads; // tid -> thread, nullptr if the tid is free
+    std::vector<std::vector<uint64_t>> free_levels; // [0] = one bit per tid, set if free
+    int max_threads;
+
+    void grow();
+    void set_free(int tid);
+    void set_used(int tid);
+
+
+public:
+
+    explicit ThreadTable(int max_threads);
+
+    Thread *get(int tid) const;
+    int capacity() const;
+    void set_max_threads(int max_threads);
+    int allocate_tid();
+    void insert(Thread *thread);
+    void release(int tid);
+
+};
+
+
+
+#endif //OS_EX2_THREADTABLE_H
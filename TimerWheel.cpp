@@ -0,0 +1,155 @@
+//
+// Created by tetrukavi on 02/05/2021.
+//
+
+#include "TimerWheel.h"
+
+#define WHEEL_TICK_NS (1UL << WHEEL_TICK_SHIFT)
+#define WHEEL_SPAN (1UL << (WHEEL_SLOT_BITS * WHEEL_LEVELS)) /* ticks the wheel covers */
+
+
+/*
+ * This function returns true if no thread sleeps
+ */
+bool TimerWheel::empty() const {
+    return length == 0;
+}
+
+/*
+ * This function returns the number of sleeping threads
+ */
+long TimerWheel::size() const {
+    return length;
+}
+
+/*
+ * This function puts the thread in the slot of its wake time - the lowest
+ * level whose slots still tell its tick (or block) apart from the others
+ */
+void TimerWheel::place(Thread *thread) {
+    // round up - the thread never wakes before its wake time
+    unsigned long tick = (thread->get_wake_time() + WHEEL_TICK_NS - 1) >> WHEEL_TICK_SHIFT;
+    if (tick < base) {
+        tick = base;
+    }
+    if (tick - base >= WHEEL_SPAN) {
+        // placed again when the wheel reaches the last block it covers
+        tick = base + WHEEL_SPAN - 1;
+    }
+    int level = 0;
+    while ((level < WHEEL_LEVELS - 1) && (tick - base >= (1UL << (WHEEL_SLOT_BITS * (level + 1))))) {
+        level++;
+    }
+    int slot = (int)((tick >> (WHEEL_SLOT_BITS * level)) & (WHEEL_SLOTS - 1));
+    slots[level][slot].push_back(thread);
+    occupied[level] |= 1ULL << slot;
+}
+
+/*
+ * This function moves all the threads of the slot to the end of threads
+ */
+void TimerWheel::take(int level, int slot, ThreadQueue &threads) {
+    ThreadQueue &queue = slots[level][slot];
+    while (!queue.empty()) {
+        threads.push_back(queue.pop_front());
+    }
+    occupied[level] &= ~(1ULL << slot);
+}
+
+/*
+ * This function returns the first tick (from base) at which a thread wakes
+ * up or a block moves down a level
+ */
+unsigned long TimerWheel::next_event_tick() const {
+    unsigned long first = ~0UL;
+    for (int level = 0; level < WHEEL_LEVELS; level++) {
+        if (occupied[level] == 0) {
+            continue;
+        }
+        int shift = WHEEL_SLOT_BITS * level;
+        // the block of base moved down when the wheel reached its start
+        unsigned long block = base >> shift;
+        if ((base & ((1UL << shift) - 1)) != 0) {
+            block++;
+        }
+        // the first occupied slot from the slot of block
+        int start = (int)(block & (WHEEL_SLOTS - 1));
+        unsigned long long rotated = occupied[level];
+        if (start != 0) {
+            rotated = (rotated >> start) | (rotated << (WHEEL_SLOTS - start));
+        }
+        unsigned long tick = (block + __builtin_ctzll(rotated)) << shift;
+        first = (tick < first) ? tick : first;
+    }
+    return first;
+}
+
+/*
+ * This function adds the running thread, whose wake time is set, to the
+ * wheel
+ */
+void TimerWheel::insert(Thread *thread, unsigned long now_ns) {
+    if (length == 0) {
+        base = now_ns >> WHEEL_TICK_SHIFT;
+    }
+    place(thread);
+    length++;
+}
+
+/*
+ * This function removes a sleeping thread before it wakes up
+ */
+void TimerWheel::remove(Thread *thread) {
+    ThreadQueue *queue = thread->get_queue();
+    queue->remove(thread);
+    length--;
+    if (queue->empty()) {
+        long index = queue - &slots[0][0];
+        occupied[index / WHEEL_SLOTS] &= ~(1ULL << (index % WHEEL_SLOTS));
+    }
+}
+
+/*
+ * This function moves the wheel to now_ns, and the threads that wake up
+ * until then to the end of woken
+ */
+void TimerWheel::advance(unsigned long now_ns, ThreadQueue &woken) {
+    unsigned long now_tick = now_ns >> WHEEL_TICK_SHIFT;
+    while (length > 0) {
+        unsigned long tick = next_event_tick();
+        if (tick > now_tick) {
+            break;
+        }
+        base = tick;
+        // the blocks that start at this tick move down, from the lowest level up
+        for (int level = 1; level < WHEEL_LEVELS; level++) {
+            int shift = WHEEL_SLOT_BITS * level;
+            if ((base & ((1UL << shift) - 1)) != 0) {
+                break;
+            }
+            ThreadQueue moved;
+            take(level, (int)((base >> shift) & (WHEEL_SLOTS - 1)), moved);
+            while (!moved.empty()) {
+                place(moved.pop_front());
+            }
+        }
+        int woken_before = woken.size();
+        take(0, (int)(base & (WHEEL_SLOTS - 1)), woken);
+        length -= woken.size() - woken_before;
+        base++;
+    }
+    if (base <= now_tick) {
+        base = now_tick + 1;
+    }
+}
+
+/*
+ * This function returns the first time (monotonic ns) the wheel has to be
+ * advanced - no thread wakes up before it - 0 if no thread sleeps
+ */
+unsigned long TimerWheel::next_expiry() const {
+    if (length == 0) {
+        return 0;
+    }
+    return next_event_tick() << WHEEL_TICK_SHIFT;
+}
@@ -0,0 +1,56 @@
+//
+// Created by tetrukavi on 02/05/2021.
+//
+
+#ifndef OS_EX2_TIMERWHEEL_H
+#define OS_EX2_TIMERWHEEL_H
+
+#include "Thread.h"
+#include "ThreadQueue.h"
+
+#define WHEEL_LEVELS 4
+#define WHEEL_SLOT_BITS 6
+#define WHEEL_SLOTS (1 << WHEEL_SLOT_BITS)
+#define WHEEL_TICK_SHIFT 16 /* a tick of the wheel is 2^16 ns (about 65 microseconds) */
+
+
+/*
+ * This class holds the sleeping threads (see uthread_sleep_usec) by their
+ * wake time, in a hierarchical timing wheel: level 0 has a slot for each of
+ * the next 64 ticks, level 1 for each of the next 64 blocks of 64 ticks, and
+ * so on - about 18 minutes in all (a later wake time waits in the last
+ * level, and is placed again when it is reached). When the wheel reaches
+ * the start of a block, the threads of the block's slot move down to the
+ * slots of its ticks. The slots are ThreadQueues, so a thread is inserted
+ * and removed in O(1), and the occupied slots are kept in a bitmap per
+ * level, so the wheel skips the ticks with nothing to do. It is shared by
+ * all the workers, and used only in the library's critical section.
+ */
+class TimerWheel {
+
+private:
+
+    ThreadQueue slots[WHEEL_LEVELS][WHEEL_SLOTS];
+    unsigned long long occupied[WHEEL_LEVELS] = {}; // bit i - slots[level][i] is not empty
+    unsigned long base = 0; // the next tick to expire
+    long length = 0;
+
+    void place(Thread *thread);
+    void take(int level, int slot, ThreadQueue &threads);
+    unsigned long next_event_tick() const;
+
+
+public:
+
+    bool empty() const;
+    long size() const;
+    void insert(Thread *thread, unsigned long now_ns);
+    void remove(Thread *thread);
+    void advance(unsigned long now_ns, ThreadQueue &woken);
+    unsigned long next_expiry() const;
+
+};
+
+
+
+#endif //OS_EX2_TIMERWHEEL_H
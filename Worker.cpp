@@ -0,0 +1,94 @@
+//
+// Created by tetrukavi on 02/05/2021.
+//
+
+#include "Worker.h"
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+
+/*
+ * This is the constructor of the worker
+ */
+Worker::Worker(int id) : id(id), kernel_thread(pthread_self()) {
+}
+
+/*
+ * This function returns the index of the worker
+ */
+int Worker::get_id() const {
+    return id;
+}
+
+/*
+ * This function returns the ready queue of the worker
+ */
+RunQueue &Worker::get_ready_threads() {
+    return ready_threads;
+}
+
+/*
+ * This function returns the ready queue of the worker in fair scheduling
+ */
+FairRunQueue &Worker::get_fair_threads() {
+    return fair_threads;
+}
+
+/*
+ * This function returns the thread the worker runs when its queue is empty
+ */
+Thread *Worker::get_idle_thread() const {
+    return idle_thread;
+}
+
+void Worker::set_idle_thread(Thread *thread) {
+    idle_thread = thread;
+}
+
+/*
+ * This function returns the kernel thread of the worker
+ */
+pthread_t Worker::get_kernel_thread() const {
+    return kernel_thread;
+}
+
+void Worker::set_kernel_thread(pthread_t thread) {
+    kernel_thread = thread;
+}
+
+/*
+ * This function returns true if the worker is idle and (about to) sleep
+ */
+bool Worker::is_sleeping() const {
+    return sleeping.load();
+}
+
+void Worker::set_sleeping(bool is_sleeping) {
+    sleeping.store(is_sleeping);
+}
+
+/*
+ * This function returns the number of wake() calls so far - read it before
+ * leaving the critical section and pass it to wait()
+ */
+int Worker::get_wakeups() const {
+    return wakeups.load();
+}
+
+/*
+ * This function sleeps until wake() is called, unless it was already called
+ * since seen_wakeups was read - or until timeout (relative) passes, if it is
+ * not nullptr
+ */
+void Worker::wait(int seen_wakeups, const struct timespec *timeout) {
+    syscall(SYS_futex, &wakeups, FUTEX_WAIT_PRIVATE, seen_wakeups, timeout, nullptr, 0);
+}
+
+/*
+ * This function wakes the worker if it sleeps in wait()
+ */
+void Worker::wake() {
+    wakeups.fetch_add(1);
+    syscall(SYS_futex, &wakeups, FUTEX_WAKE_PRIVATE, 1, nullptr, nullptr, 0);
+}
@@ -0,0 +1,58 @@
+//
+// Created by tetrukavi on 02/05/2021.
+//
+
+#ifndef OS_EX2_WORKER_H
+#define OS_EX2_WORKER_H
+
+#include <atomic>
+#include <pthread.h>
+#include <time.h>
+#include "Thread.h"
+#include "RunQueue.h"
+#include "FairRunQueue.h"
+
+
+/*
+ * This class represents a kernel thread that runs uthreads (M:N mode, see
+ * uthread_init_ex) - its work-stealing ready queue (or its fair queue, in
+ * fair scheduling), and the idle thread it switches to when the queue is
+ * empty. The idle thread steals threads from the other workers, and sleeps
+ * in wait() when there are none, until a worker that makes a thread ready
+ * calls wake().
+ */
+class Worker {
+
+private:
+
+    int id;
+    RunQueue ready_threads; // the ready threads of this worker, other workers steal from it
+    FairRunQueue fair_threads; // the ready threads instead, in fair scheduling
+    Thread *idle_thread = nullptr;
+    pthread_t kernel_thread;
+    std::atomic<int> wakeups{0}; // futex word - changed by every wake()
+    std::atomic<bool> sleeping{false}; // the idle thread is about to wait() or waits
+
+
+public:
+
+    explicit Worker(int id);
+
+    int get_id() const;
+    RunQueue &get_ready_threads();
+    FairRunQueue &get_fair_threads();
+    Thread *get_idle_thread() const;
+    void set_idle_thread(Thread *thread);
+    pthread_t get_kernel_thread() const;
+    void set_kernel_thread(pthread_t thread);
+    bool is_sleeping() const;
+    void set_sleeping(bool is_sleeping);
+    int get_wakeups() const;
+    void wait(int seen_wakeups, const struct timespec *timeout);
+    void wake();
+
+};
+
+
+
+#endif //OS_EX2_WORKER_H
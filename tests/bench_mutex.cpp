@@ -0,0 +1,70 @@
+/**********************************************
+ * Benchmark: mutex contention
+ *
+ * WORKERS threads take turns on one mutex, and each holds it until it has
+ * been preempted once, so the others queue up on it. A lock call that
+ * blocked is a contended acquire; the quantums the locker got inside the
+ * call are the times it was woken. Ideally every contended acquire is woken
+ * once - each extra wake is a switch to a waiter that found the mutex taken
+ * again and went back to sleep.
+ *
+ **********************************************/
+
+#include <cstdio>
+#include "uthreads.h"
+
+#define WORKERS 8
+#define ITERATIONS 50
+
+uthread_mutex_t mutex;
+volatile long counter = 0;
+volatile int done = 0;
+long contended = 0;
+long wakes = 0;
+
+
+void worker()
+{
+    int tid = uthread_get_tid();
+    for (int i = 0; i < ITERATIONS; i++)
+    {
+        int before = uthread_get_quantums(tid);
+        uthread_mutex_lock_ex(&mutex);
+        if (uthread_get_quantums(tid) != before)
+        {
+            contended++;
+            wakes += uthread_get_quantums(tid) - before;
+        }
+        long value = counter;
+        // stay in the critical section until the next quantum
+        int quantums = uthread_get_quantums(tid);
+        while (uthread_get_quantums(tid) == quantums)
+        {}
+        counter = value + 1;
+        uthread_mutex_unlock_ex(&mutex);
+    }
+    done++;
+    uthread_terminate(tid);
+}
+
+int main()
+{
+    uthread_init(1000);
+    uthread_mutex_init(&mutex);
+    for (int i = 0; i < WORKERS; i++)
+    {
+        uthread_spawn(worker);
+    }
+
+    int start_quantums = uthread_get_total_quantums();
+    while (done < WORKERS)
+    {}
+    int switches = uthread_get_total_quantums() - start_quantums;
+
+    printf("%ld acquires (%s), %ld contended, %.3f wakes per contended acquire, %d switches\n",
+           counter, counter == WORKERS * ITERATIONS ? "ok" : "LOST UPDATES",
+           contended, (double) wakes / contended, switches);
+    uthread_mutex_destroy(&mutex);
+    uthread_terminate(0);
+    return 0;
+}
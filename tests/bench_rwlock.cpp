@@ -0,0 +1,150 @@
+/**********************************************
+ * Benchmark: reader-writer lock against the mutex
+ *
+ * WORKERS threads each do OPERATIONS operations on a shared table - a read
+ * sums it, a write updates all of it - under one lock: the mutex, the
+ * reader-writer lock, or the reader-writer lock with writer preference.
+ * Each operation holds the lock until it has been preempted once, so the
+ * others run into it. Readers under the mutex go one at a time; under the
+ * reader-writer lock they share it, and the readers queued behind a writer
+ * all get it together when it unlocks. The fewer quantums a run takes, the
+ * more operations overlapped - so it is run at several ratios of writes.
+ *
+ **********************************************/
+
+#include <cstdio>
+#include "uthreads.h"
+
+#define WORKERS 8
+#define OPERATIONS 25
+#define TABLE_SIZE 64
+
+#define LOCK_MUTEX 0
+#define LOCK_RWLOCK 1
+#define LOCK_RWLOCK_PREFER_WRITERS 2
+
+uthread_mutex_t mutex;
+uthread_rwlock_t rwlock;
+uthread_waitgroup_t finished;
+int lock_kind;
+int write_percent;
+volatile long table[TABLE_SIZE];
+volatile long torn_reads = 0;
+long writes = 0;
+long blocked = 0;
+
+
+void lock(bool write)
+{
+    if (lock_kind == LOCK_MUTEX)
+    {
+        uthread_mutex_lock_ex(&mutex);
+    }
+    else if (write)
+    {
+        uthread_rwlock_wrlock(&rwlock);
+    }
+    else
+    {
+        uthread_rwlock_rdlock(&rwlock);
+    }
+}
+
+void unlock()
+{
+    if (lock_kind == LOCK_MUTEX)
+    {
+        uthread_mutex_unlock_ex(&mutex);
+    }
+    else
+    {
+        uthread_rwlock_unlock(&rwlock);
+    }
+}
+
+void *worker(void *arg)
+{
+    long id = (long) arg;
+    int tid = uthread_get_tid();
+    for (int i = 0; i < OPERATIONS; i++)
+    {
+        // spread the writes evenly over the operations of all the workers
+        bool write = (i * WORKERS + id) % 100 < write_percent;
+        int before = uthread_get_quantums(tid);
+        lock(write);
+        if (uthread_get_quantums(tid) != before)
+        {
+            blocked++;
+        }
+        // stay in the critical section until the next quantum
+        int quantums = uthread_get_quantums(tid);
+        if (write)
+        {
+            writes++;
+            for (int j = 0; j < TABLE_SIZE; j++)
+            {
+                table[j] = table[j] + 1;
+            }
+            while (uthread_get_quantums(tid) == quantums)
+            {}
+        }
+        else
+        {
+            long first = table[0];
+            while (uthread_get_quantums(tid) == quantums)
+            {}
+            for (int j = 0; j < TABLE_SIZE; j++)
+            {
+                if (table[j] != first)
+                {
+                    torn_reads++;
+                }
+            }
+        }
+        unlock();
+    }
+    uthread_waitgroup_done(&finished);
+    return nullptr;
+}
+
+void run(int kind, int percent)
+{
+    const char *names[] = {"mutex", "rwlock", "rwlock (prefer writers)"};
+    lock_kind = kind;
+    write_percent = percent;
+    writes = 0;
+    blocked = 0;
+    uthread_waitgroup_add(&finished, WORKERS);
+    int start_quantums = uthread_get_total_quantums();
+    for (long i = 0; i < WORKERS; i++)
+    {
+        uthread_spawn_arg(worker, (void *) i, nullptr);
+    }
+    uthread_waitgroup_wait(&finished);
+    int switches = uthread_get_total_quantums() - start_quantums;
+
+    printf("%3d%% writes, %-24s %4ld writes, %4ld blocked acquires, %5d switches, %.2f operations per quantum\n",
+           percent, names[kind], writes, blocked, switches, (double) (WORKERS * OPERATIONS) / switches);
+}
+
+int main()
+{
+    const int percents[] = {0, 1, 10, 50};
+    uthread_init(1000);
+    uthread_mutex_init(&mutex);
+    uthread_waitgroup_init(&finished);
+    for (int percent : percents)
+    {
+        for (int kind = LOCK_MUTEX; kind <= LOCK_RWLOCK_PREFER_WRITERS; kind++)
+        {
+            uthread_rwlock_init(&rwlock, kind == LOCK_RWLOCK_PREFER_WRITERS);
+            run(kind, percent);
+            uthread_rwlock_destroy(&rwlock);
+        }
+    }
+    printf("%s\n", torn_reads == 0 ? "ok" : "TORN READS");
+    uthread_waitgroup_destroy(&finished);
+    uthread_mutex_destroy(&mutex);
+    uthread_terminate(0);
+    return 0;
+}
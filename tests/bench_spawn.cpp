@@ -0,0 +1,84 @@
+/**********************************************
+ * Benchmark: spawn / terminate scaling
+ *
+ * For growing populations, main spawns N threads, terminates every other
+ * one, spawns N/2 again (they reuse the lowest free ids) and terminates all.
+ * The cost per operation should stay flat as N grows.
+ * The library is initialized with room for the largest population, which
+ * may be given as an argument - "bench_spawn 1048576" runs a million
+ * threads. Past the guarded stacks, the stacks of deleted threads stay
+ * mapped for the next ones, so the churn doesn't run out of mappings
+ * (vm.max_map_count) - the address space and memory are the limit.
+ *
+ **********************************************/
+
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+#include <time.h>
+#include "uthreads.h"
+
+
+double now_ns()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+void idle()
+{
+    while (true)
+    {
+        uthread_block(uthread_get_tid());
+    }
+}
+
+int main(int argc, char **argv)
+{
+    int max_population = argc > 1 ? atoi(argv[1]) : 1 << 16;
+    uthread_options_t options;
+    uthread_options_init(&options);
+    options.max_threads = max_population + 1;
+    uthread_init_ex(999999, &options);
+
+    printf("%10s %12s %12s %12s\n", "threads", "spawn ns", "respawn ns", "terminate ns");
+    for (int n = 1024; n <= max_population; n *= 4)
+    {
+        std::vector<int> tids(n);
+
+        double start = now_ns();
+        for (int i = 0; i < n; i++)
+        {
+            tids[i] = uthread_spawn(idle);
+            if (tids[i] == -1)
+            {
+                printf("spawn failed at %d threads\n", i);
+                uthread_terminate(0);
+            }
+        }
+        double spawn_ns = (now_ns() - start) / n;
+
+        start = now_ns();
+        for (int i = 0; i < n; i += 2)
+        {
+            uthread_terminate(tids[i]);
+        }
+        for (int i = 0; i < n; i += 2)
+        {
+            tids[i] = uthread_spawn(idle);
+        }
+        double respawn_ns = (now_ns() - start) / n;
+
+        start = now_ns();
+        for (int i = 0; i < n; i++)
+        {
+            uthread_terminate(tids[i]);
+        }
+        double terminate_ns = (now_ns() - start) / n;
+
+        printf("%10d %12.1f %12.1f %12.1f\n", n, spawn_ns, respawn_ns, terminate_ns);
+    }
+    uthread_terminate(0);
+    return 0;
+}
@@ -0,0 +1,143 @@
+/**********************************************
+ * Benchmark: context switch cost
+ *
+ * Two threads ping-pong while main waits on the mutex, so every iteration
+ * is exactly two switches. Three ways are timed:
+ *  - uthread_resume / uthread_block, which also restarts the quantum timer
+ *    (a setitimer call) on every switch;
+ *  - uthread_yield with yield_keeps_quantum, which leaves the timer alone
+ *    but still goes through the scheduler and the ready queue;
+ *  - a direct Thread::switch_to between the two threads inside the
+ *    critical section - only the save / restore of the context itself.
+ * Build it once as is and once with -DUTHREADS_ASM_SWITCH to compare the
+ * sigsetjmp/siglongjmp path with the assembly switch.
+ *
+ **********************************************/
+
+#include <cstdio>
+#include <time.h>
+#include "uthreads.h"
+#include "Thread.h"
+
+#define ITERATIONS 200000
+
+// library internals used by the direct switch (see uthreads.cpp)
+extern thread_local Thread *running_thread_ptr;
+void block_signals();
+void unblock_signals();
+Thread *get_thread(int tid);
+
+enum { BLOCK_RESUME, YIELD, DIRECT, PHASES };
+const char *phase_names[PHASES] = {"uthread_block / uthread_resume", "uthread_yield", "direct switch"};
+
+int ping_tid, pong_tid;
+int phase = BLOCK_RESUME;
+double elapsed_ns[PHASES];
+
+
+double now_ns()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+// switches directly to the other thread, as the running thread
+void switch_to(Thread *self, Thread *other)
+{
+    running_thread_ptr = other;
+    self->switch_to(other);
+}
+
+void pong()
+{
+    while (phase == BLOCK_RESUME)
+    {
+        uthread_resume(ping_tid);
+        uthread_block(pong_tid);
+    }
+    while (phase == YIELD)
+    {
+        uthread_yield();
+    }
+    // ping switched here, and uthread_yield left the critical section
+    block_signals();
+    Thread *self = get_thread(pong_tid);
+    Thread *other = get_thread(ping_tid);
+    while (phase == DIRECT)
+    {
+        switch_to(self, other);
+    }
+    // the scheduler switched here - this is the running thread again
+    unblock_signals();
+    while (true)
+    {
+        uthread_block(pong_tid);
+    }
+}
+
+void ping()
+{
+    uthread_mutex_lock();
+    double start = now_ns();
+    for (int i = 0; i < ITERATIONS; i++)
+    {
+        uthread_resume(pong_tid);
+        uthread_block(ping_tid);
+    }
+    elapsed_ns[BLOCK_RESUME] = now_ns() - start;
+
+    // pong is blocked - it goes on yielding once it runs again
+    phase = YIELD;
+    uthread_resume(pong_tid);
+    start = now_ns();
+    for (int i = 0; i < ITERATIONS; i++)
+    {
+        uthread_yield();
+    }
+    elapsed_ns[YIELD] = now_ns() - start;
+
+    // pong is ready in uthread_yield - the first switch returns from it
+    phase = DIRECT;
+    block_signals();
+    Thread *self = get_thread(ping_tid);
+    Thread *other = get_thread(pong_tid);
+    start = now_ns();
+    for (int i = 0; i < ITERATIONS; i++)
+    {
+        switch_to(self, other);
+    }
+    elapsed_ns[DIRECT] = now_ns() - start;
+    // pong is still ready as far as the scheduler knows - if it runs it
+    // leaves its loop
+    phase = PHASES;
+    unblock_signals();
+
+    uthread_terminate(pong_tid);
+    uthread_mutex_unlock();
+    uthread_terminate(ping_tid);
+}
+
+int main()
+{
+    uthread_options_t options;
+    uthread_options_init(&options);
+    options.yield_keeps_quantum = 1;
+    uthread_init_ex(100000, &options);
+    ping_tid = uthread_spawn(ping);
+    pong_tid = uthread_spawn(pong);
+
+    // wait until ping holds the mutex, then sleep on it for the whole run
+    while (uthread_get_quantums(ping_tid) == 0)
+    {}
+    uthread_mutex_lock();
+    uthread_mutex_unlock();
+
+    for (int i = 0; i < PHASES; i++)
+    {
+        printf("%-32s %d switches, %.1f ns per switch\n", phase_names[i], 2 * ITERATIONS,
+               elapsed_ns[i] / (2.0 * ITERATIONS));
+    }
+    uthread_terminate(0);
+    return 0;
+}
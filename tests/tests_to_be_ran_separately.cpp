@@ -5,6 +5,7 @@
 #include <algorithm>
 #include <ctime>
 #include <regex>
+#include <sys/resource.h>
 
 /* !!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!
  *                        IMPORTANT
@@ -975,6 +976,9 @@ TEST(Test14, MutexTest8)
 
         EXPECT_EQ(uthread_mutex_lock(),0);
 
+        // t3 waited for the mutex first, so it was handed to t3
+        EXPECT_TRUE(ran2);
+
         ran = true;
 
         EXPECT_EQ(uthread_mutex_unlock(),0);
@@ -990,7 +994,7 @@ TEST(Test14, MutexTest8)
         EXPECT_EQ(uthread_mutex_lock(),0);
 
 
-        EXPECT_TRUE(ran);
+        EXPECT_FALSE(ran);
 
         ran2 = true;
 
@@ -1012,6 +1016,7 @@ TEST(Test14, MutexTest8)
     threadQuantumSleep(1);
 
 
+    EXPECT_TRUE(ran);
     EXPECT_TRUE(ran2);
 
 
@@ -1168,3 +1173,1076 @@ TEST(Test16, MutexTest10)
 
 
 
+
+/** The max_threads option lifts the limit of MAX_THREAD_NUM threads without a rebuild */
+TEST(Test17, MaxThreadsOption)
+{
+    uthread_options_t options;
+    ASSERT_EQ(uthread_options_init(&options), 0);
+    EXPECT_EQ(options.max_threads, MAX_THREAD_NUM);
+
+    options.max_threads = 0;
+    expect_thread_library_error([&](){
+        return uthread_init_ex(100 * MILLISECOND, &options);
+    });
+
+    const int MAX_THREADS = 10 * MAX_THREAD_NUM;
+    options.max_threads = MAX_THREADS;
+    ASSERT_EQ(uthread_init_ex(100 * MILLISECOND, &options), 0);
+
+    auto f = [](){
+        while (true) {}
+    };
+    // including the main thread, we may have MAX_THREADS threads
+    for (int i = 1; i < MAX_THREADS; ++i)
+    {
+        ASSERT_EQ(uthread_spawn(f), i);
+    }
+    expect_thread_library_error([&](){ return uthread_spawn(f);});
+
+    // the freed ids are reused from the lowest up
+    EXPECT_EQ(uthread_terminate(MAX_THREADS / 2), 0);
+    EXPECT_EQ(uthread_terminate(MAX_THREAD_NUM), 0);
+    EXPECT_EQ(uthread_spawn(f), MAX_THREAD_NUM);
+    EXPECT_EQ(uthread_spawn(f), MAX_THREADS / 2);
+
+    ASSERT_EXIT(uthread_terminate(0), ::testing::ExitedWithCode(0), "");
+}
+
+/** uthread_spawn_ex gives each thread the stack size of its attributes */
+TEST(Test18, SpawnWithStackSize)
+{
+    int priorites = 100 * MILLISECOND;
+    initializeWithPriorities(priorites);
+
+    uthread_attr_t attrs;
+    ASSERT_EQ(uthread_attr_init(&attrs), 0);
+    EXPECT_EQ(attrs.stack_size, STACK_SIZE);
+
+    static auto f = [](){
+        while (true) {}
+    };
+
+    // stacks smaller than MIN_STACK_SIZE are refused
+    attrs.stack_size = MIN_STACK_SIZE - 1;
+    expect_thread_library_error([&](){ return uthread_spawn_ex(f, &attrs);});
+    attrs.stack_size = -1;
+    expect_thread_library_error([&](){ return uthread_spawn_ex(f, &attrs);});
+
+    // a thread with a large stack can use much more than STACK_SIZE of it
+    static volatile bool ran_large = false;
+    auto large = [](){
+        volatile char buffer[64 * STACK_SIZE];
+        for (unsigned int i = 0; i < sizeof(buffer); i += 512)
+        {
+            buffer[i] = (char)i;
+        }
+        ran_large = (buffer[512] == (char)512);
+        EXPECT_EQ(uthread_terminate(uthread_get_tid()), 0);
+    };
+    attrs.stack_size = 128 * STACK_SIZE;
+    EXPECT_EQ(uthread_spawn_ex(large, &attrs), 1);
+
+    // the smallest stack, the default one and NULL attrs all run
+    static volatile int ran_small = 0;
+    auto small = [](){
+        ran_small++;
+        EXPECT_EQ(uthread_terminate(uthread_get_tid()), 0);
+    };
+    attrs.stack_size = MIN_STACK_SIZE;
+    EXPECT_EQ(uthread_spawn_ex(small, &attrs), 2);
+    attrs.stack_size = 0;
+    EXPECT_EQ(uthread_spawn_ex(small, &attrs), 3);
+    EXPECT_EQ(uthread_spawn_ex(small, nullptr), 4);
+
+    threadQuantumSleep(1);
+
+    EXPECT_TRUE(ran_large);
+    EXPECT_EQ(ran_small, 3);
+
+    // the terminated threads (and their stacks) are reused, whatever their size
+    EXPECT_EQ(uthread_spawn_ex(small, nullptr), 1);
+    attrs.stack_size = 128 * STACK_SIZE;
+    EXPECT_EQ(uthread_spawn_ex(large, &attrs), 2);
+    threadQuantumSleep(1);
+    EXPECT_EQ(ran_small, 4);
+
+    ASSERT_EXIT(uthread_terminate(0), ::testing::ExitedWithCode(0), "");
+}
+
+/** uthread_yield switches to the next READY thread at once, in round robin order */
+TEST(Test19, Yield)
+{
+    int priorites = 100 * MILLISECOND;
+    initializeWithPriorities(priorites);
+
+    // with no other thread READY, the main thread goes on (in a new quantum)
+    EXPECT_EQ(uthread_yield(), 0);
+    EXPECT_EQ(uthread_get_tid(), 0);
+    EXPECT_EQ(uthread_get_quantums(0), 2);
+    EXPECT_EQ(uthread_get_total_quantums(), 2);
+
+    static std::vector<int> order;
+    auto t = [](){
+        int tid = uthread_get_tid();
+        for (int i = 0; i < 3; ++i)
+        {
+            order.push_back(tid);
+            EXPECT_EQ(uthread_yield(), 0);
+        }
+        EXPECT_EQ(uthread_terminate(tid), 0);
+    };
+    EXPECT_EQ(uthread_spawn(t), 1);
+    EXPECT_EQ(uthread_spawn(t), 2);
+
+    for (int i = 0; i < 4; ++i)
+    {
+        order.push_back(0);
+        EXPECT_EQ(uthread_yield(), 0);
+    }
+
+    std::vector<int> expectedOrder {0, 1, 2, 0, 1, 2, 0, 1, 2, 0};
+    EXPECT_EQ(order, expectedOrder);
+    // every switch started a quantum: 2 before the loop, 3 in each of the
+    // three rounds, and 3 in the last one (the threads terminate)
+    EXPECT_EQ(uthread_get_total_quantums(), 2 + 3 * 3 + 3);
+
+    ASSERT_EXIT(uthread_terminate(0), ::testing::ExitedWithCode(0), "");
+}
+
+/** with several workers, the Threads run on all of them and every one of
+ *  them finishes, while they yield and share a mutex */
+TEST(Test20, MultipleWorkers)
+{
+    uthread_options_t options;
+    ASSERT_EQ(uthread_options_init(&options), 0);
+    options.workers = 4;
+    ASSERT_EQ(uthread_init_ex(10 * MILLISECOND, &options), 0);
+
+    const int THREADS = 16;
+    const int ROUNDS = 200;
+    static uthread_mutex_t mutex;
+    static uthread_waitgroup_t finished;
+    static long shared = 0;
+    static int rounds[THREADS];
+    ASSERT_EQ(uthread_mutex_init(&mutex), 0);
+    ASSERT_EQ(uthread_waitgroup_init(&finished), 0);
+    ASSERT_EQ(uthread_waitgroup_add(&finished, THREADS), 0);
+
+    auto t = [](void *arg) -> void * {
+        long id = (long) arg;
+        for (int i = 0; i < ROUNDS; ++i)
+        {
+            EXPECT_EQ(uthread_mutex_lock_ex(&mutex), 0);
+            shared++;
+            EXPECT_EQ(uthread_mutex_unlock_ex(&mutex), 0);
+            rounds[id]++;
+            EXPECT_EQ(uthread_yield(), 0);
+        }
+        EXPECT_EQ(uthread_waitgroup_done(&finished), 0);
+        return nullptr;
+    };
+    for (long i = 0; i < THREADS; ++i)
+    {
+        ASSERT_GT(uthread_spawn_arg(t, (void *) i, nullptr), 0);
+    }
+    EXPECT_EQ(uthread_waitgroup_wait(&finished), 0);
+
+    EXPECT_EQ(shared, (long) THREADS * ROUNDS);
+    for (int i = 0; i < THREADS; ++i)
+    {
+        EXPECT_EQ(rounds[i], ROUNDS);
+    }
+
+    ASSERT_EXIT(uthread_terminate(0), ::testing::ExitedWithCode(0), "");
+}
+
+/** a Thread that terminates itself while a stale entry of it (left by
+ *  uthread_set_priority) is still queued is released only once the entry
+ *  is taken - not freed under it */
+TEST(Test21, TerminateWithStaleReadyEntry)
+{
+    uthread_options_t options;
+    ASSERT_EQ(uthread_options_init(&options), 0);
+    // no pool - a released thread is deleted
+    options.pool_size = 0;
+    options.pool_prewarm = 0;
+    ASSERT_EQ(uthread_init_ex(100 * MILLISECOND, &options), 0);
+
+    static std::vector<int> order;
+    auto t = [](){
+        int tid = uthread_get_tid();
+        order.push_back(tid);
+        EXPECT_EQ(uthread_terminate(tid), 0);
+    };
+    EXPECT_EQ(uthread_set_priority(0, 0), 0);
+    for (int round = 0; round < 3; ++round)
+    {
+        EXPECT_EQ(uthread_spawn(t), 1);
+        // moving the READY thread leaves its entry at DEFAULT_PRIORITY behind
+        EXPECT_EQ(uthread_set_priority(1, 0), 0);
+        EXPECT_EQ(uthread_yield(), 0);
+        EXPECT_EQ(uthread_get_tid(), 0);
+    }
+    // the main thread takes the stale entries once it is less urgent
+    EXPECT_EQ(uthread_set_priority(0, PRIORITY_LEVELS - 1), 0);
+    EXPECT_EQ(uthread_yield(), 0);
+
+    std::vector<int> expectedOrder {1, 1, 1};
+    EXPECT_EQ(order, expectedOrder);
+
+    ASSERT_EXIT(uthread_terminate(0), ::testing::ExitedWithCode(0), "");
+}
+
+/** the most urgent READY thread runs first, and the threads of the same
+ *  priority run in the order they became READY */
+TEST(Test22, PriorityOrder)
+{
+    int priorites = 100 * MILLISECOND;
+    initializeWithPriorities(priorites);
+
+    static std::vector<int> order;
+    auto t = [](){
+        int tid = uthread_get_tid();
+        order.push_back(tid);
+        EXPECT_EQ(uthread_terminate(tid), 0);
+    };
+    EXPECT_EQ(uthread_set_priority(0, 0), 0);
+    const int priorities[] = {5, 1, 5, 0, 3};
+    for (int i = 0; i < 5; ++i)
+    {
+        EXPECT_EQ(uthread_spawn(t), i + 1);
+        EXPECT_EQ(uthread_set_priority(i + 1, priorities[i]), 0);
+        EXPECT_EQ(uthread_get_priority(i + 1), priorities[i]);
+    }
+    expect_thread_library_error([](){ return uthread_set_priority(1, PRIORITY_LEVELS);});
+    expect_thread_library_error([](){ return uthread_set_priority(1, -1);});
+
+    // thread 4 has the main thread's priority, and runs after it yields
+    EXPECT_EQ(uthread_yield(), 0);
+    std::vector<int> expectedOrder {4};
+    EXPECT_EQ(order, expectedOrder);
+
+    // the less urgent main thread is preempted at once
+    EXPECT_EQ(uthread_set_priority(0, PRIORITY_LEVELS - 1), 0);
+    expectedOrder = {4, 2, 5, 1, 3};
+    EXPECT_EQ(order, expectedOrder);
+
+    ASSERT_EXIT(uthread_terminate(0), ::testing::ExitedWithCode(0), "");
+}
+
+/** with several workers, threads terminate themselves while stale entries
+ *  of them (left by uthread_set_priority) are in the deques of other
+ *  workers, which steal them - each thread is released only once */
+TEST(Test23, TerminateWithStaleEntriesOnWorkers)
+{
+    uthread_options_t options;
+    ASSERT_EQ(uthread_options_init(&options), 0);
+    options.workers = 4;
+    // no pool - a released thread is deleted
+    options.pool_size = 0;
+    options.pool_prewarm = 0;
+    ASSERT_EQ(uthread_init_ex(MILLISECOND, &options), 0);
+
+    const int THREADS = 16;
+    const int ROUNDS = 100;
+    static uthread_mutex_t mutex;
+    static uthread_waitgroup_t finished;
+    static int tids[THREADS];
+    static bool done[THREADS];
+    ASSERT_EQ(uthread_mutex_init(&mutex), 0);
+    ASSERT_EQ(uthread_waitgroup_init(&finished), 0);
+    ASSERT_EQ(uthread_waitgroup_add(&finished, THREADS), 0);
+
+    auto t = [](void *arg) -> void * {
+        long id = (long) arg;
+        for (int i = 0; i < ROUNDS; ++i)
+        {
+            // move the other threads, most of them READY, between levels
+            EXPECT_EQ(uthread_mutex_lock_ex(&mutex), 0);
+            for (int j = 1; j < THREADS; j += 3)
+            {
+                int other = (id + j) % THREADS;
+                if (!done[other])
+                {
+                    EXPECT_EQ(uthread_set_priority(tids[other], (i + j) % PRIORITY_LEVELS), 0);
+                }
+            }
+            EXPECT_EQ(uthread_mutex_unlock_ex(&mutex), 0);
+            EXPECT_EQ(uthread_yield(), 0);
+        }
+        EXPECT_EQ(uthread_mutex_lock_ex(&mutex), 0);
+        done[id] = true;
+        EXPECT_EQ(uthread_mutex_unlock_ex(&mutex), 0);
+        EXPECT_EQ(uthread_waitgroup_done(&finished), 0);
+        EXPECT_EQ(uthread_terminate(uthread_get_tid()), 0);
+        return nullptr;
+    };
+    EXPECT_EQ(uthread_mutex_lock_ex(&mutex), 0);
+    for (long i = 0; i < THREADS; ++i)
+    {
+        tids[i] = uthread_spawn_arg(t, (void *) i, nullptr);
+        ASSERT_GT(tids[i], 0);
+        EXPECT_EQ(uthread_detach(tids[i]), 0);
+    }
+    EXPECT_EQ(uthread_mutex_unlock_ex(&mutex), 0);
+    EXPECT_EQ(uthread_waitgroup_wait(&finished), 0);
+    for (int i = 0; i < THREADS; ++i)
+    {
+        EXPECT_TRUE(done[i]);
+    }
+
+    ASSERT_EXIT(uthread_terminate(0), ::testing::ExitedWithCode(0), "");
+}
+
+/** with UTHREAD_POLICY_FAIR, spinning threads share the CPU by the weights
+ *  of their priorities, and a thread that waited runs soon after it wakes */
+TEST(Test24, FairShares)
+{
+    uthread_options_t options;
+    ASSERT_EQ(uthread_options_init(&options), 0);
+    options.policy = UTHREAD_POLICY_FAIR;
+    ASSERT_EQ(uthread_init_ex(2 * MILLISECOND, &options), 0);
+
+    auto spin = [](){
+        while (true) {}
+    };
+    // the weight of a priority grows by 1.25 per level, so thread 2 weighs
+    // 1.25 ^ 3 (about twice) as much as the main thread and thread 1
+    EXPECT_EQ(uthread_spawn(spin), 1);
+    EXPECT_EQ(uthread_spawn(spin), 2);
+    EXPECT_EQ(uthread_set_priority(2, DEFAULT_PRIORITY - 3), 0);
+
+    static volatile int woken_at = 0;
+    auto sleeper = [](){
+        EXPECT_EQ(uthread_block(uthread_get_tid()), 0);
+        woken_at = uthread_get_total_quantums();
+        while (true) {}
+    };
+    EXPECT_EQ(uthread_spawn(sleeper), 3);
+
+    while (uthread_get_total_quantums() < 300) {}
+    int main_quantums = uthread_get_quantums(0);
+    int equal_quantums = uthread_get_quantums(1);
+    int heavy_quantums = uthread_get_quantums(2);
+    EXPECT_NEAR(equal_quantums, main_quantums, main_quantums / 5 + 2);
+    EXPECT_GT(heavy_quantums, equal_quantums * 3 / 2);
+    EXPECT_LT(heavy_quantums, equal_quantums * 5 / 2);
+
+    // the thread that waited is behind the others, and runs next
+    int resumed_at = uthread_get_total_quantums();
+    EXPECT_EQ(uthread_resume(3), 0);
+    while (woken_at == 0) {}
+    EXPECT_LE(woken_at, resumed_at + 2);
+
+    ASSERT_EXIT(uthread_terminate(0), ::testing::ExitedWithCode(0), "");
+}
+
+/** periodic threads are admitted while their densities sum to at most 1,
+ *  run a job every period, and a job that runs past its budget misses its
+ *  deadline */
+TEST(Test25, PeriodicAdmissionAndDeadlines)
+{
+    uthread_options_t options;
+    ASSERT_EQ(uthread_options_init(&options), 0);
+    options.clock = UTHREAD_CLOCK_MONOTONIC;
+    ASSERT_EQ(uthread_init_ex(MILLISECOND, &options), 0);
+
+    static auto spin_for = [](long usecs){
+        struct timespec start, now;
+        clock_gettime(CLOCK_MONOTONIC, &start);
+        do
+        {
+            clock_gettime(CLOCK_MONOTONIC, &now);
+        } while ((now.tv_sec - start.tv_sec) * SECOND + (now.tv_nsec - start.tv_nsec) / 1000 < usecs);
+    };
+    auto light = [](){
+        spin_for(MILLISECOND);
+    };
+    auto heavy = [](){
+        spin_for(30 * MILLISECOND);
+    };
+
+    expect_thread_library_error([&](){ return uthread_spawn_periodic(light, 0, 1, 1);});
+    expect_thread_library_error([&](){ return uthread_spawn_periodic(light, 10, 0, 10);});
+    // a budget longer than the deadline, a deadline longer than the period
+    expect_thread_library_error([&](){ return uthread_spawn_periodic(light, 10, 6, 5);});
+    expect_thread_library_error([&](){ return uthread_spawn_periodic(light, 10, 5, 11);});
+
+    // densities 0.2 and 0.2
+    EXPECT_EQ(uthread_spawn_periodic(light, 20 * MILLISECOND, 2 * MILLISECOND, 10 * MILLISECOND), 1);
+    EXPECT_EQ(uthread_spawn_periodic(heavy, 50 * MILLISECOND, 5 * MILLISECOND, 25 * MILLISECOND), 2);
+    // 0.7 more would need more than one CPU
+    expect_thread_library_error([&](){
+        return uthread_spawn_periodic(light, 10 * MILLISECOND, 7 * MILLISECOND, 10 * MILLISECOND);
+    });
+    EXPECT_EQ(uthread_spawn_periodic(light, 10 * MILLISECOND, 6 * MILLISECOND, 10 * MILLISECOND), 3);
+    EXPECT_EQ(uthread_terminate(3), 0);
+
+    // the main thread runs whenever no job does
+    spin_for(400 * MILLISECOND);
+
+    uthread_periodic_stats_t stats;
+    ASSERT_EQ(uthread_get_periodic_stats(1, &stats), 0);
+    EXPECT_GE(stats.jobs, 15);
+    EXPECT_EQ(stats.missed_deadlines, 0);
+    EXPECT_EQ(stats.overruns, 0);
+    ASSERT_EQ(uthread_get_periodic_stats(2, &stats), 0);
+    EXPECT_GE(stats.jobs, 3);
+    EXPECT_GT(stats.overruns, 0);
+    EXPECT_GT(stats.missed_deadlines, 0);
+    EXPECT_GE(stats.max_response_usecs, 25 * MILLISECOND);
+
+    expect_thread_library_error([&](){ return uthread_get_periodic_stats(0, &stats);});
+    expect_thread_library_error([&](){ return uthread_get_periodic_stats(3, &stats);});
+
+    ASSERT_EXIT(uthread_terminate(0), ::testing::ExitedWithCode(0), "");
+}
+
+/** sleeping threads wake up in the order of their wake times, not before
+ *  them, and a sleeping thread that is blocked stays BLOCKED */
+TEST(Test26, SleepOrder)
+{
+    uthread_options_t options;
+    ASSERT_EQ(uthread_options_init(&options), 0);
+    options.clock = UTHREAD_CLOCK_MONOTONIC;
+    ASSERT_EQ(uthread_init_ex(MILLISECOND, &options), 0);
+
+    static auto now_usecs = [](){
+        struct timespec now;
+        clock_gettime(CLOCK_MONOTONIC, &now);
+        return (long) now.tv_sec * SECOND + now.tv_nsec / 1000;
+    };
+    static long start = now_usecs();
+    static std::vector<int> order;
+    static long slept[5];
+    // thread i sleeps (4 - i) * 10 ms, thread 3 until an absolute time
+    auto sleeper = [](){
+        int tid = uthread_get_tid();
+        if (tid == 3)
+        {
+            struct timespec wake_time;
+            clock_gettime(CLOCK_MONOTONIC, &wake_time);
+            // in nanoseconds
+            wake_time.tv_nsec += 10 * MILLISECOND * 1000;
+            wake_time.tv_sec += wake_time.tv_nsec / (SECOND * 1000);
+            wake_time.tv_nsec %= SECOND * 1000;
+            EXPECT_EQ(uthread_sleep_until(&wake_time), 0);
+        }
+        else
+        {
+            EXPECT_EQ(uthread_sleep_usec((4 - tid) * 10 * MILLISECOND), 0);
+        }
+        slept[tid] = now_usecs() - start;
+        order.push_back(tid);
+        EXPECT_EQ(uthread_terminate(tid), 0);
+    };
+    for (int i = 1; i <= 3; ++i)
+    {
+        EXPECT_EQ(uthread_spawn(sleeper), i);
+    }
+
+    expect_thread_library_error([](){ return uthread_sleep_usec(-1);});
+    struct timespec invalid = {0, SECOND * 1000};
+    expect_thread_library_error([&](){ return uthread_sleep_until(&invalid);});
+    // a time that passed returns at once
+    struct timespec passed = {0, 0};
+    EXPECT_EQ(uthread_sleep_until(&passed), 0);
+
+    // the main thread sleeps too, while the others wait
+    EXPECT_EQ(uthread_sleep_usec(40 * MILLISECOND), 0);
+    EXPECT_GE(now_usecs() - start, 40 * MILLISECOND);
+
+    std::vector<int> expectedOrder {3, 2, 1};
+    EXPECT_EQ(order, expectedOrder);
+    EXPECT_GE(slept[3], 10 * MILLISECOND);
+    EXPECT_GE(slept[2], 20 * MILLISECOND);
+    EXPECT_GE(slept[1], 30 * MILLISECOND);
+
+    // a blocked sleeper doesn't run when it wakes up, but once resumed
+    EXPECT_EQ(uthread_spawn(sleeper), 1);
+    EXPECT_EQ(uthread_yield(), 0);
+    EXPECT_EQ(uthread_block(1), 0);
+    EXPECT_EQ(uthread_sleep_usec(40 * MILLISECOND), 0);
+    EXPECT_EQ(order.size(), 3u);
+    EXPECT_EQ(uthread_resume(1), 0);
+    EXPECT_EQ(uthread_yield(), 0);
+    expectedOrder = {3, 2, 1, 1};
+    EXPECT_EQ(order, expectedOrder);
+
+    ASSERT_EXIT(uthread_terminate(0), ::testing::ExitedWithCode(0), "");
+}
+
+/** joinable threads keep their ID until they are joined or detached, and
+ *  uthread_join gives the result of their routine or of uthread_exit */
+TEST(Test27, JoinDetachExit)
+{
+    int priorites = 100 * MILLISECOND;
+    initializeWithPriorities(priorites);
+
+    auto twice = [](void *arg) -> void * {
+        return (void *) ((long) arg * 2);
+    };
+    static auto exit_from_nested = [](long result){
+        uthread_exit((void *) result);
+    };
+    auto exits = [](void *arg) -> void * {
+        exit_from_nested((long) arg);
+        ADD_FAILURE() << "uthread_exit returned";
+        return nullptr;
+    };
+    auto spin = [](void *arg) -> void * {
+        while (true) {}
+        return arg;
+    };
+
+    // joining a thread that hasn't run yet waits for it
+    void *result = nullptr;
+    EXPECT_EQ(uthread_spawn_arg(twice, (void *) 21, nullptr), 1);
+    EXPECT_EQ(uthread_join(1, &result), 0);
+    EXPECT_EQ((long) result, 42);
+
+    // a finished thread is a zombie until it is joined - its ID is taken
+    EXPECT_EQ(uthread_spawn_arg(exits, (void *) 7, nullptr), 1);
+    EXPECT_EQ(uthread_yield(), 0);
+    EXPECT_EQ(uthread_spawn_arg(twice, (void *) 1, nullptr), 2);
+    EXPECT_EQ(uthread_join(1, &result), 0);
+    EXPECT_EQ((long) result, 7);
+    EXPECT_EQ(uthread_join(2, nullptr), 0);
+    // both IDs are free again
+    EXPECT_EQ(uthread_spawn_arg(spin, nullptr, nullptr), 1);
+    EXPECT_EQ(uthread_spawn_arg(spin, nullptr, nullptr), 2);
+
+    // a thread terminated by another one gives NULL
+    result = (void *) 1;
+    EXPECT_EQ(uthread_terminate(1), 0);
+    EXPECT_EQ(uthread_join(1, &result), 0);
+    EXPECT_EQ(result, nullptr);
+
+    // a detached thread is freed when it terminates, and can't be joined
+    EXPECT_EQ(uthread_detach(2), 0);
+    expect_thread_library_error([](){ return uthread_detach(2);});
+    expect_thread_library_error([](){ return uthread_join(2, nullptr);});
+    EXPECT_EQ(uthread_terminate(2), 0);
+    // and a zombie that is detached is freed at once
+    EXPECT_EQ(uthread_spawn_arg(twice, nullptr, nullptr), 1);
+    EXPECT_EQ(uthread_yield(), 0);
+    EXPECT_EQ(uthread_detach(1), 0);
+    expect_thread_library_error([](){ return uthread_join(1, nullptr);});
+    EXPECT_EQ(uthread_spawn_arg(spin, nullptr, nullptr), 1);
+    EXPECT_EQ(uthread_spawn_arg(spin, nullptr, nullptr), 2);
+
+    // only one thread may join a thread, and not itself
+    static int joined = 0;
+    auto joiner = [](void *arg) -> void * {
+        EXPECT_EQ(uthread_join((int) (long) arg, nullptr), 0);
+        joined++;
+        return nullptr;
+    };
+    EXPECT_EQ(uthread_spawn_arg(joiner, (void *) 1, nullptr), 3);
+    EXPECT_EQ(uthread_yield(), 0);
+    expect_thread_library_error([](){ return uthread_join(1, nullptr);});
+    expect_thread_library_error([](){ return uthread_detach(1);});
+    expect_thread_library_error([](){ return uthread_join(0, nullptr);});
+    expect_thread_library_error([](){ return uthread_join(9, nullptr);});
+    auto detached = [](){
+        while (true) {}
+    };
+    EXPECT_EQ(uthread_spawn(detached), 4);
+    expect_thread_library_error([](){ return uthread_join(4, nullptr);});
+    EXPECT_EQ(joined, 0);
+    EXPECT_EQ(uthread_terminate(1), 0);
+    EXPECT_EQ(uthread_join(3, nullptr), 0);
+    EXPECT_EQ(joined, 1);
+
+    ASSERT_EXIT(uthread_terminate(0), ::testing::ExitedWithCode(0), "");
+}
+
+/** a signalled thread waits for the mutex instead of becoming READY, and
+ *  the threads woken by a broadcast get the mutex one by one, in order */
+TEST(Test28, CondSignalAndBroadcast)
+{
+    int priorites = 100 * MILLISECOND;
+    initializeWithPriorities(priorites);
+
+    static uthread_mutex_t mutex;
+    static uthread_cond_t cond;
+    ASSERT_EQ(uthread_mutex_init(&mutex), 0);
+    ASSERT_EQ(uthread_cond_init(&cond), 0);
+    expect_thread_library_error([](){ return uthread_cond_wait(&cond, &mutex);});
+
+    static int waiting = 0;
+    static int holding = 0;
+    static int finished = 0;
+    static std::vector<int> woken;
+    auto waiter = [](){
+        EXPECT_EQ(uthread_mutex_lock_ex(&mutex), 0);
+        waiting++;
+        EXPECT_EQ(uthread_cond_wait(&cond, &mutex), 0);
+        // it holds the mutex again, alone
+        holding++;
+        EXPECT_EQ(holding, 1);
+        woken.push_back(uthread_get_tid());
+        waiting--;
+        EXPECT_EQ(uthread_yield(), 0);
+        holding--;
+        EXPECT_EQ(uthread_mutex_unlock_ex(&mutex), 0);
+        finished++;
+        EXPECT_EQ(uthread_terminate(uthread_get_tid()), 0);
+    };
+    for (int i = 1; i <= 3; ++i)
+    {
+        EXPECT_EQ(uthread_spawn(waiter), i);
+    }
+    EXPECT_EQ(uthread_yield(), 0);
+    EXPECT_EQ(waiting, 3);
+    expect_thread_library_error([](){ return uthread_cond_destroy(&cond);});
+
+    // the signalled thread waits for the mutex the main thread holds
+    EXPECT_EQ(uthread_mutex_lock_ex(&mutex), 0);
+    EXPECT_EQ(uthread_cond_signal(&cond), 0);
+    EXPECT_EQ(uthread_yield(), 0);
+    EXPECT_TRUE(woken.empty());
+    EXPECT_EQ(uthread_mutex_unlock_ex(&mutex), 0);
+    for (int i = 0; (i < 3) && (finished < 1); ++i)
+    {
+        EXPECT_EQ(uthread_yield(), 0);
+    }
+    std::vector<int> expectedWoken {1};
+    EXPECT_EQ(woken, expectedWoken);
+
+    // the broadcast moves the others to the waiters of the mutex
+    EXPECT_EQ(uthread_mutex_lock_ex(&mutex), 0);
+    EXPECT_EQ(uthread_cond_broadcast(&cond), 0);
+    EXPECT_EQ(uthread_yield(), 0);
+    EXPECT_EQ(woken, expectedWoken);
+    EXPECT_EQ(uthread_mutex_unlock_ex(&mutex), 0);
+    for (int i = 0; (i < 10) && (finished < 3); ++i)
+    {
+        EXPECT_EQ(uthread_yield(), 0);
+    }
+    expectedWoken = {1, 2, 3};
+    EXPECT_EQ(woken, expectedWoken);
+
+    // with no waiters, signals are lost
+    EXPECT_EQ(uthread_cond_signal(&cond), 0);
+    EXPECT_EQ(uthread_cond_broadcast(&cond), 0);
+    EXPECT_EQ(uthread_cond_destroy(&cond), 0);
+    EXPECT_EQ(uthread_mutex_destroy(&mutex), 0);
+
+    ASSERT_EXIT(uthread_terminate(0), ::testing::ExitedWithCode(0), "");
+}
+
+/** a semaphore counts its units, and hands a posted unit to the first
+ *  waiting thread */
+TEST(Test29, SemaphoreCounting)
+{
+    int priorites = 100 * MILLISECOND;
+    initializeWithPriorities(priorites);
+
+    static uthread_sem_t sem;
+    uthread_sem_t invalid;
+    expect_thread_library_error([&](){ return uthread_sem_init(&invalid, -1);});
+    ASSERT_EQ(uthread_sem_init(&sem, 2), 0);
+    EXPECT_EQ(uthread_sem_getvalue(&sem), 2);
+    EXPECT_EQ(uthread_sem_trywait(&sem), 0);
+    EXPECT_EQ(uthread_sem_wait(&sem), 0);
+    EXPECT_EQ(uthread_sem_getvalue(&sem), 0);
+    EXPECT_EQ(uthread_sem_trywait(&sem), 1);
+
+    static std::vector<int> order;
+    auto waiter = [](){
+        EXPECT_EQ(uthread_sem_wait(&sem), 0);
+        order.push_back(uthread_get_tid());
+        EXPECT_EQ(uthread_terminate(uthread_get_tid()), 0);
+    };
+    for (int i = 1; i <= 3; ++i)
+    {
+        EXPECT_EQ(uthread_spawn(waiter), i);
+    }
+    EXPECT_EQ(uthread_yield(), 0);
+    EXPECT_TRUE(order.empty());
+    EXPECT_EQ(uthread_sem_getvalue(&sem), 0);
+    expect_thread_library_error([](){ return uthread_sem_destroy(&sem);});
+
+    // each unit goes to the first waiter, not to the count
+    EXPECT_EQ(uthread_sem_post(&sem), 0);
+    EXPECT_EQ(uthread_sem_post(&sem), 0);
+    EXPECT_EQ(uthread_sem_getvalue(&sem), 0);
+    EXPECT_EQ(uthread_yield(), 0);
+    std::vector<int> expectedOrder {1, 2};
+    EXPECT_EQ(order, expectedOrder);
+
+    // and once nobody waits, the units add up
+    EXPECT_EQ(uthread_sem_post(&sem), 0);
+    EXPECT_EQ(uthread_sem_post(&sem), 0);
+    EXPECT_EQ(uthread_sem_post(&sem), 0);
+    EXPECT_EQ(uthread_sem_getvalue(&sem), 2);
+    EXPECT_EQ(uthread_yield(), 0);
+    expectedOrder = {1, 2, 3};
+    EXPECT_EQ(order, expectedOrder);
+    EXPECT_EQ(uthread_sem_destroy(&sem), 0);
+
+    ASSERT_EXIT(uthread_terminate(0), ::testing::ExitedWithCode(0), "");
+}
+
+/** a barrier releases its threads once count of them arrived, round after
+ *  round; a latch and a wait group release their waiters at zero */
+TEST(Test30, BarrierLatchWaitGroup)
+{
+    int priorites = 100 * MILLISECOND;
+    initializeWithPriorities(priorites);
+
+    static uthread_barrier_t barrier;
+    uthread_barrier_t invalid_barrier;
+    expect_thread_library_error([&](){ return uthread_barrier_init(&invalid_barrier, 0);});
+    ASSERT_EQ(uthread_barrier_init(&barrier, 3), 0);
+    static int arrived = 0;
+    static int serial = 0;
+    auto party = [](){
+        for (int round = 0; round < 2; ++round)
+        {
+            arrived++;
+            int ret = uthread_barrier_wait(&barrier);
+            EXPECT_TRUE((ret == 0) || (ret == UTHREAD_BARRIER_SERIAL_THREAD));
+            serial += (ret == UTHREAD_BARRIER_SERIAL_THREAD);
+            // all the others arrived in this round before anyone went on
+            EXPECT_GE(arrived, 3 * (round + 1));
+        }
+        EXPECT_EQ(uthread_terminate(uthread_get_tid()), 0);
+    };
+    EXPECT_EQ(uthread_spawn(party), 1);
+    EXPECT_EQ(uthread_spawn(party), 2);
+    EXPECT_EQ(uthread_yield(), 0);
+    EXPECT_EQ(arrived, 2);
+    expect_thread_library_error([](){ return uthread_barrier_destroy(&barrier);});
+    // the main thread is the third party of both rounds
+    for (int round = 0; round < 2; ++round)
+    {
+        arrived++;
+        int ret = uthread_barrier_wait(&barrier);
+        serial += (ret == UTHREAD_BARRIER_SERIAL_THREAD);
+        EXPECT_GE(arrived, 3 * (round + 1));
+    }
+    EXPECT_EQ(uthread_yield(), 0);
+    EXPECT_EQ(serial, 2);
+    EXPECT_EQ(uthread_barrier_destroy(&barrier), 0);
+
+    static uthread_latch_t latch;
+    uthread_latch_t invalid_latch;
+    expect_thread_library_error([&](){ return uthread_latch_init(&invalid_latch, -1);});
+    ASSERT_EQ(uthread_latch_init(&latch, 2), 0);
+    static int passed = 0;
+    auto latch_waiter = [](){
+        EXPECT_EQ(uthread_latch_wait(&latch), 0);
+        passed++;
+        EXPECT_EQ(uthread_terminate(uthread_get_tid()), 0);
+    };
+    EXPECT_EQ(uthread_spawn(latch_waiter), 1);
+    EXPECT_EQ(uthread_spawn(latch_waiter), 2);
+    EXPECT_EQ(uthread_yield(), 0);
+    EXPECT_EQ(uthread_latch_count_down(&latch), 0);
+    EXPECT_EQ(uthread_yield(), 0);
+    EXPECT_EQ(passed, 0);
+    expect_thread_library_error([](){ return uthread_latch_destroy(&latch);});
+    EXPECT_EQ(uthread_latch_count_down(&latch), 0);
+    EXPECT_EQ(uthread_yield(), 0);
+    EXPECT_EQ(passed, 2);
+    // it is one-shot
+    expect_thread_library_error([](){ return uthread_latch_count_down(&latch);});
+    EXPECT_EQ(uthread_latch_wait(&latch), 0);
+    EXPECT_EQ(uthread_latch_destroy(&latch), 0);
+
+    static uthread_waitgroup_t group;
+    ASSERT_EQ(uthread_waitgroup_init(&group), 0);
+    EXPECT_EQ(uthread_waitgroup_wait(&group), 0);
+    expect_thread_library_error([](){ return uthread_waitgroup_add(&group, -1);});
+    static int done = 0;
+    auto worker = [](){
+        done++;
+        EXPECT_EQ(uthread_waitgroup_done(&group), 0);
+        EXPECT_EQ(uthread_terminate(uthread_get_tid()), 0);
+    };
+    // the count goes up again after it reached zero
+    for (int round = 1; round <= 2; ++round)
+    {
+        EXPECT_EQ(uthread_waitgroup_add(&group, 3), 0);
+        for (int i = 1; i <= 3; ++i)
+        {
+            EXPECT_EQ(uthread_spawn(worker), i);
+        }
+        EXPECT_EQ(uthread_waitgroup_wait(&group), 0);
+        EXPECT_EQ(done, 3 * round);
+        EXPECT_EQ(uthread_yield(), 0);
+    }
+    EXPECT_EQ(uthread_waitgroup_destroy(&group), 0);
+
+    ASSERT_EXIT(uthread_terminate(0), ::testing::ExitedWithCode(0), "");
+}
+
+/** only a holder releases a reader-writer lock; with writer preference new
+ *  readers wait for a waiting writer and then go in one batch; a terminated
+ *  thread releases the locks it holds */
+TEST(Test31, RWLock)
+{
+    int priorites = 100 * MILLISECOND;
+    initializeWithPriorities(priorites);
+
+    static uthread_rwlock_t rwlock;
+    ASSERT_EQ(uthread_rwlock_init(&rwlock, 0), 0);
+    expect_thread_library_error([](){ return uthread_rwlock_unlock(&rwlock);});
+
+    // a thread that doesn't hold the lock can't release it
+    EXPECT_EQ(uthread_rwlock_rdlock(&rwlock), 0);
+    auto stranger = [](){
+        expect_thread_library_error([](){ return uthread_rwlock_unlock(&rwlock);});
+        EXPECT_EQ(uthread_terminate(uthread_get_tid()), 0);
+    };
+    EXPECT_EQ(uthread_spawn(stranger), 1);
+    EXPECT_EQ(uthread_yield(), 0);
+    // a reader may take it again, but not for writing
+    EXPECT_EQ(uthread_rwlock_rdlock(&rwlock), 0);
+    expect_thread_library_error([](){ return uthread_rwlock_wrlock(&rwlock);});
+    EXPECT_EQ(uthread_rwlock_unlock(&rwlock), 0);
+    EXPECT_EQ(uthread_rwlock_unlock(&rwlock), 0);
+    expect_thread_library_error([](){ return uthread_rwlock_unlock(&rwlock);});
+    EXPECT_EQ(uthread_rwlock_wrlock(&rwlock), 0);
+    expect_thread_library_error([](){ return uthread_rwlock_rdlock(&rwlock);});
+    expect_thread_library_error([](){ return uthread_rwlock_destroy(&rwlock);});
+    EXPECT_EQ(uthread_rwlock_unlock(&rwlock), 0);
+    EXPECT_EQ(uthread_rwlock_destroy(&rwlock), 0);
+
+    static std::vector<int> order;
+    static int reading = 0;
+    static int max_reading = 0;
+    auto writer = [](){
+        EXPECT_EQ(uthread_rwlock_wrlock(&rwlock), 0);
+        order.push_back(uthread_get_tid());
+        EXPECT_EQ(reading, 0);
+        EXPECT_EQ(uthread_rwlock_unlock(&rwlock), 0);
+        EXPECT_EQ(uthread_terminate(uthread_get_tid()), 0);
+    };
+    auto reader = [](){
+        EXPECT_EQ(uthread_rwlock_rdlock(&rwlock), 0);
+        order.push_back(uthread_get_tid());
+        reading++;
+        max_reading = std::max(max_reading, reading);
+        EXPECT_EQ(uthread_yield(), 0);
+        reading--;
+        EXPECT_EQ(uthread_rwlock_unlock(&rwlock), 0);
+        EXPECT_EQ(uthread_terminate(uthread_get_tid()), 0);
+    };
+
+    // without writer preference, a new reader joins the readers
+    ASSERT_EQ(uthread_rwlock_init(&rwlock, 0), 0);
+    EXPECT_EQ(uthread_rwlock_rdlock(&rwlock), 0);
+    EXPECT_EQ(uthread_spawn(writer), 1);
+    EXPECT_EQ(uthread_spawn(reader), 2);
+    EXPECT_EQ(uthread_yield(), 0);
+    std::vector<int> expectedOrder {2};
+    EXPECT_EQ(order, expectedOrder);
+    EXPECT_EQ(uthread_rwlock_unlock(&rwlock), 0);
+    for (int i = 0; (i < 5) && (order.size() < 2); ++i)
+    {
+        EXPECT_EQ(uthread_yield(), 0);
+    }
+    expectedOrder = {2, 1};
+    EXPECT_EQ(order, expectedOrder);
+    EXPECT_EQ(uthread_yield(), 0);
+    EXPECT_EQ(uthread_rwlock_destroy(&rwlock), 0);
+
+    // with writer preference, new readers wait for the writer, and then
+    // all of them hold the lock together
+    order.clear();
+    ASSERT_EQ(uthread_rwlock_init(&rwlock, 1), 0);
+    EXPECT_EQ(uthread_rwlock_rdlock(&rwlock), 0);
+    EXPECT_EQ(uthread_spawn(writer), 1);
+    EXPECT_EQ(uthread_yield(), 0);
+    EXPECT_EQ(uthread_spawn(reader), 2);
+    EXPECT_EQ(uthread_spawn(reader), 3);
+    EXPECT_EQ(uthread_yield(), 0);
+    EXPECT_TRUE(order.empty());
+    // the main thread holds it already, so it doesn't wait for itself
+    EXPECT_EQ(uthread_rwlock_rdlock(&rwlock), 0);
+    EXPECT_EQ(uthread_rwlock_unlock(&rwlock), 0);
+    EXPECT_EQ(uthread_rwlock_unlock(&rwlock), 0);
+    for (int i = 0; (i < 10) && ((order.size() < 3) || (reading > 0)); ++i)
+    {
+        EXPECT_EQ(uthread_yield(), 0);
+    }
+    expectedOrder = {1, 2, 3};
+    EXPECT_EQ(order, expectedOrder);
+    EXPECT_EQ(max_reading, 2);
+
+    // a terminated holder releases the lock to the waiting reader
+    order.clear();
+    auto blocked_writer = [](){
+        EXPECT_EQ(uthread_rwlock_wrlock(&rwlock), 0);
+        EXPECT_EQ(uthread_block(uthread_get_tid()), 0);
+    };
+    EXPECT_EQ(uthread_spawn(blocked_writer), 1);
+    EXPECT_EQ(uthread_yield(), 0);
+    EXPECT_EQ(uthread_spawn(reader), 2);
+    EXPECT_EQ(uthread_yield(), 0);
+    EXPECT_TRUE(order.empty());
+    EXPECT_EQ(uthread_terminate(1), 0);
+    for (int i = 0; (i < 5) && ((order.size() < 1) || (reading > 0)); ++i)
+    {
+        EXPECT_EQ(uthread_yield(), 0);
+    }
+    expectedOrder = {2};
+    EXPECT_EQ(order, expectedOrder);
+    EXPECT_EQ(uthread_rwlock_destroy(&rwlock), 0);
+
+    ASSERT_EXIT(uthread_terminate(0), ::testing::ExitedWithCode(0), "");
+}
+
+/** spawning and terminating 2^20 threads, up to 65536 at a time, with
+ *  holes between the live ones (like tests/bench_spawn) reuses the stacks
+ *  without a guard page - the process doesn't run out of mappings */
+TEST(Test32, SpawnChurnKeepsMappings)
+{
+    const int LIVE = 1 << 16;
+    const int ROUNDS = 11; // of 1.5 * LIVE spawns
+    uthread_options_t options;
+    ASSERT_EQ(uthread_options_init(&options), 0);
+    options.max_threads = LIVE + 1;
+    ASSERT_EQ(uthread_init_ex(SECOND, &options), 0);
+
+    static auto count_mappings = [](){
+        FILE *maps = fopen("/proc/self/maps", "r");
+        int lines = 0;
+        int c;
+        while ((c = fgetc(maps)) != EOF)
+        {
+            lines += (c == '\n');
+        }
+        fclose(maps);
+        return lines;
+    };
+    // the threads run once, so terminating them frees them at once
+    auto f = [](){
+        while (true)
+        {
+            uthread_block(uthread_get_tid());
+        }
+    };
+    int full_mappings = 0;
+    for (int round = 0; round < ROUNDS; ++round)
+    {
+        for (int i = 1; i <= LIVE; ++i)
+        {
+            ASSERT_EQ(uthread_spawn(f), i);
+        }
+        EXPECT_EQ(uthread_yield(), 0);
+        if (round == 0)
+        {
+            full_mappings = count_mappings();
+        }
+        // every other thread leaves a hole between the stacks
+        for (int i = 1; i <= LIVE; i += 2)
+        {
+            ASSERT_EQ(uthread_terminate(i), 0);
+        }
+        EXPECT_LE(count_mappings(), full_mappings + 64);
+        for (int i = 1; i <= LIVE; i += 2)
+        {
+            ASSERT_EQ(uthread_spawn(f), i);
+        }
+        EXPECT_EQ(uthread_yield(), 0);
+        for (int i = 1; i <= LIVE; ++i)
+        {
+            ASSERT_EQ(uthread_terminate(i), 0);
+        }
+    }
+    EXPECT_LE(count_mappings(), full_mappings + 64);
+
+    ASSERT_EXIT(uthread_terminate(0), ::testing::ExitedWithCode(0), "");
+}
+
+/** a thread whose stack can't be mapped isn't spawned, and takes no ID */
+TEST(Test33, SpawnWithoutMemory)
+{
+    initializeWithPriorities(100 * MILLISECOND);
+    auto f = [](){
+        while (true) {}
+    };
+
+    // leave the process no room for more mappings
+    long pages = 0;
+    FILE *statm = fopen("/proc/self/statm", "r");
+    ASSERT_EQ(fscanf(statm, "%ld", &pages), 1);
+    fclose(statm);
+    struct rlimit old_limit;
+    ASSERT_EQ(getrlimit(RLIMIT_AS, &old_limit), 0);
+    struct rlimit limit = old_limit;
+    limit.rlim_cur = (rlim_t)pages * sysconf(_SC_PAGESIZE);
+    ASSERT_EQ(setrlimit(RLIMIT_AS, &limit), 0);
+
+    uthread_attr_t attrs;
+    ASSERT_EQ(uthread_attr_init(&attrs), 0);
+    expect_thread_library_error([&](){ return uthread_spawn_ex(f, &attrs);});
+    expect_thread_library_error([&](){ return uthread_spawn_periodic(f, SECOND, MILLISECOND, SECOND);});
+    ASSERT_EQ(setrlimit(RLIMIT_AS, &old_limit), 0);
+
+    // nothing was left behind
+    EXPECT_EQ(uthread_spawn_ex(f, &attrs), 1);
+    EXPECT_EQ(uthread_spawn(f), 2);
+    EXPECT_EQ(uthread_get_total_quantums(), 1);
+
+    ASSERT_EXIT(uthread_terminate(0), ::testing::ExitedWithCode(0), "");
+}
+
+/** a thread holds at most MAX_HELD_RWLOCKS reader-writer locks, however
+ *  many times it holds each for reading */
+TEST(Test34, RWLockHoldLimit)
+{
+    initializeWithPriorities(100 * MILLISECOND);
+
+    static uthread_rwlock_t rwlocks[MAX_HELD_RWLOCKS + 1];
+    for (int i = 0; i <= MAX_HELD_RWLOCKS; ++i)
+    {
+        ASSERT_EQ(uthread_rwlock_init(&rwlocks[i], 0), 0);
+    }
+    for (int i = 0; i < MAX_HELD_RWLOCKS; ++i)
+    {
+        EXPECT_EQ(uthread_rwlock_rdlock(&rwlocks[i]), 0);
+    }
+    expect_thread_library_error([](){ return uthread_rwlock_rdlock(&rwlocks[MAX_HELD_RWLOCKS]);});
+    expect_thread_library_error([](){ return uthread_rwlock_wrlock(&rwlocks[MAX_HELD_RWLOCKS]);});
+    // another hold of a lock it holds takes no room
+    EXPECT_EQ(uthread_rwlock_rdlock(&rwlocks[0]), 0);
+    EXPECT_EQ(uthread_rwlock_unlock(&rwlocks[0]), 0);
+
+    // releasing one makes room, and the first is still held once
+    EXPECT_EQ(uthread_rwlock_unlock(&rwlocks[1]), 0);
+    EXPECT_EQ(uthread_rwlock_wrlock(&rwlocks[MAX_HELD_RWLOCKS]), 0);
+    EXPECT_EQ(uthread_rwlock_unlock(&rwlocks[0]), 0);
+    expect_thread_library_error([](){ return uthread_rwlock_unlock(&rwlocks[0]);});
+
+    // a terminated thread releases them all
+    static auto holder = [](){
+        for (int i = 0; i < MAX_HELD_RWLOCKS; ++i)
+        {
+            EXPECT_EQ(uthread_rwlock_rdlock(&rwlocks[i]), 0);
+        }
+        uthread_block(uthread_get_tid());
+    };
+    EXPECT_EQ(uthread_rwlock_unlock(&rwlocks[MAX_HELD_RWLOCKS]), 0);
+    for (int i = 2; i < MAX_HELD_RWLOCKS; ++i)
+    {
+        EXPECT_EQ(uthread_rwlock_unlock(&rwlocks[i]), 0);
+    }
+    int tid = uthread_spawn(holder);
+    ASSERT_EQ(tid, 1);
+    EXPECT_EQ(uthread_yield(), 0);
+    EXPECT_EQ(uthread_terminate(tid), 0);
+    for (int i = 0; i <= MAX_HELD_RWLOCKS; ++i)
+    {
+        EXPECT_EQ(uthread_rwlock_wrlock(&rwlocks[i]), 0);
+        EXPECT_EQ(uthread_rwlock_unlock(&rwlocks[i]), 0);
+        EXPECT_EQ(uthread_rwlock_destroy(&rwlocks[i]), 0);
+    }
+
+    ASSERT_EXIT(uthread_terminate(0), ::testing::ExitedWithCode(0), "");
+}
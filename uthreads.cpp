@@ -3,15 +3,35 @@
 //
 
 #include "Thread.h"
+#include "ThreadQueue.h"
+#include "ThreadTable.h"
+#include "ThreadPool.h"
+#include "Mutex.h"
+#include "CondVar.h"
+#include "Semaphore.h"
+#include "Barrier.h"
+#include "Latch.h"
+#include "RWLock.h"
+#include "Worker.h"
+#include "DeadlineQueue.h"
+#include "Reservation.h"
+#include "SchedulerPolicy.h"
+#include "TimerWheel.h"
 #include "uthreads.h"
-#include <map>
 #include <iostream>
-#include <set>
 #include <deque>
 #include <csetjmp>
 #include <csignal>
+#include <atomic>
 #include <bits/stdc++.h>
 #include <sys/time.h>
+#include <time.h>
+#include <sys/auxv.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <pthread.h>
+#include <sched.h>
+#include <unistd.h>
 
 
 /// macros ///
@@ -23,45 +43,151 @@
 
 #define RUNNING 1
 #define READY 2
+#define WAITING 3 // off the CPU and not ready - blocked or waiting for a mutex
+#define TERMINATED 4 // terminated, but still has (stale) entries in the ready deques
+#define ZOMBIE 5 // a terminated joinable thread, kept (with its tid) until it is joined
+
+#define IDLE_TID -1 // tid of the idle threads of the workers, which are not in the table
 
 #define BLOCKED true
 #define UNBLOCKED false
 
-#define READY_MAP 1
-#define BLOCKED_MAP 2
-
 
 /// declarations ///
-using std::map;
-using std::set;
 using std::deque;
 using std::pair;
 
 
 /// fields ///
-map<int, Thread*> blocked_threads; // tid, thread
-map<int, Thread*> ready_threads_map; // tid, thread
-deque<Thread*> ordered_deque_threads; // all the created threads -> first in first out
-deque<Thread*> mutex_deque_threads; // all the mutex blocked threads -> first in first out
-pair<bool, int> mutex_pair; // pair that symbolized the mutex: first = locked\unlocked, second = thread id
+ThreadTable threads_table(MAX_THREAD_NUM); // tid -> thread, and the free tids
+ThreadPool threads_pool(THREAD_POOL_SIZE); // terminated threads kept for reuse
+Mutex default_mutex; // the mutex of uthread_mutex_lock / uthread_mutex_unlock
 
 
 
 int total_quantum;
-int available_tid;
-set<int> min_available_tids;
-
-Thread* running_thread_ptr; // pointer to the running thread
-int running_dest = 1; // which contact switch to do
+int signal_frame_reserve; // bytes added to every stack for the SIGVTALRM frame
+
+thread_local Thread* running_thread_ptr; // pointer to the running thread (of this worker)
+thread_local Thread* terminated_thread = nullptr; // a thread that terminated itself, freed once we are off its stack
+thread_local int running_dest = 1; // which contact switch to do
+bool yield_keeps_quantum = false; // uthread_yield passes the rest of the quantum on
+
+
+/// workers ///
+// In M:N mode every worker is a kernel thread with its own running thread
+// (the thread_local fields) and ready deque, and the critical sections of
+// all the workers are serialized by library_lock. A thread made ready joins
+// the deque of the worker that made it ready, and idle workers take threads
+// from their own deque and steal from the deques of the others without the
+// lock (the lock-free policies) - only claiming the thread is done under
+// it. The system calls of a critical section - waking sleeping workers and
+// reprogramming the worker's timer - are deferred until the lock is
+// released (see unblock_signals).
+// Since a thread may continue on another worker after a switch, the
+// thread_local fields are always read directly, never through a pointer
+// taken before the switch.
+std::vector<Worker*> workers; // workers[0] runs on the main kernel thread
+int workers_num = 1;
+thread_local Worker *this_worker = nullptr;
+std::atomic_flag library_lock = ATOMIC_FLAG_INIT; // taken only when workers_num > 1
+thread_local std::vector<Worker*> workers_to_wake; // woken when this worker releases library_lock
+thread_local bool timer_update_pending = false; // the timer is reprogrammed when this worker releases library_lock
+
+
+/// scheduling policy ///
+// The policy orders the ready threads of the workers (see SchedulerPolicy.h).
+// POLICY_HOOK(hook, args...) calls the hook of the policy in use: with
+// -DUTHREADS_POLICY=<class> it is that class alone, so the hooks inline into
+// the switch path, and otherwise a switch on options->policy picks it.
+#ifdef UTHREADS_POLICY
+#define POLICY_HOOK(hook, ...) (UTHREADS_POLICY::hook(__VA_ARGS__))
+#else
+int scheduling_policy = UTHREAD_POLICY_PRIORITY;
+#define POLICY_HOOK(hook, ...) \
+    ((scheduling_policy == UTHREAD_POLICY_PRIORITY) ? PriorityPolicy::hook(__VA_ARGS__) : \
+     (scheduling_policy == UTHREAD_POLICY_FAIR) ? FairPolicy::hook(__VA_ARGS__) : \
+     RoundRobinPolicy::hook(__VA_ARGS__))
+#endif
+thread_local unsigned long run_start = 0; // CPU time of this worker when the running thread was last charged
+bool run_time_measured = false; // the policy needs it, or there are periodic threads
+
+
+/// periodic threads ///
+// Threads spawned by uthread_spawn_periodic run before all the others, by
+// the deadline of their current job (EDF). Between jobs they wait in
+// release_queue, ordered by the start of their next period, and are
+// released at the scheduling decisions (and by sleeping workers, which
+// wake up for the first release).
+DeadlineQueue edf_threads; // the ready periodic threads of all the workers
+ThreadQueue release_queue; // the periodic threads that wait for their next period
+std::atomic<unsigned long> next_release{0}; // start of the first period in release_queue, 0 if it is empty
+unsigned long admitted_density = 0; // of all the periodic threads, in billionths of a CPU
+#define FULL_DENSITY 1000000000UL
+
+
+/// sleeping threads ///
+// Threads in uthread_sleep_usec / uthread_sleep_until wait in
+// sleeping_threads until their wake time, and are woken at the scheduling
+// decisions (and by sleeping workers, which wake up for the first of them).
+TimerWheel sleeping_threads;
+std::atomic<unsigned long> next_wakeup{0}; // sleeping_threads.next_expiry(), 0 if no thread sleeps
 
 
 /// timer ///
 struct sigaction sa = {0};
-struct itimerval timer;
+int preemption_clock = UTHREAD_CLOCK_VIRTUAL; // the clock the quanta are measured in
+long library_quantum_ns; // the quantum of uthread_init
+// the CPU clocks expire only at kernel ticks, but a wall-clock quantum
+// shorter than a preemption (signal delivery and switch) would leave no time
+// to run
+#define MIN_WALL_QUANTUM_NS 20000L
+bool adaptive_quantum = false; // the quantum follows the number of ready threads
+#define ADAPTIVE_QUANTUM_SCALE 4 // the adaptive quantum is between 1/4 and 4 library quanta
+bool tickless = false; // the timer is stopped while the running thread runs alone
+// the timer of every worker is programmed with the quantum of its running
+// thread (armed_quantum_ns, 0 if it is stopped), and reprogrammed only when
+// it changes or the thread must start a whole quantum (restart_quantum)
+thread_local long armed_quantum_ns = 0;
+thread_local bool restart_pending = false;
+// with the timer_create clocks (and in M:N mode) every worker has a timer of
+// its own instead of ITIMER_VIRTUAL
+thread_local timer_t worker_timer;
+// With UTHREAD_CLOCK_MONOTONIC the timer expires once, at an absolute
+// deadline. Every quantum ends at its own quantum_deadline, and a timer that
+// expires before it is moved there by reset_clock instead of preempting - so
+// switching threads doesn't reprogram the timer. (A periodic timer is rearmed
+// by the kernel as its signal is delivered, so a delivery slower than the
+// period would nest SIGVTALRM frames until the stack overflows.)
+thread_local unsigned long quantum_deadline = 0; // CLOCK_MONOTONIC ns, 0 - the next expiry ends the quantum
+thread_local unsigned long timer_expiry = 0; // CLOCK_MONOTONIC ns, 0 if the timer isn't programmed
+
+
+/// statistics ///
+// updated in the critical section (see uthread_get_sched_stats)
+bool sched_stats = false; // the latency is measured
+unsigned long init_time; // monotonic ns of uthread_init
+long long switch_count = 0;
+long long preempt_count = 0;
+long long latency_samples = 0;
+unsigned long latency_total = 0; // ns
+unsigned long latency_max = 0; // ns
+
+
+/// stack overflow ///
+struct sigaction overflow_sa = {};
+// SIGSEGV of an overflow can't be delivered on the overflowed stack, so every
+// kernel thread gets an alternate signal stack (install_signal_stack) - mapped
+// once, and unmapped when the library exits (free_signal_stack)
+thread_local stack_t signal_stack = {};
 
 
 /// signals ///
-sigset_t signal_set;
+// set while the library's data structures are being changed. SIGVTALRM that
+// arrives meanwhile only marks preempt_pending and the preemption is done
+// when the critical section ends.
+thread_local volatile sig_atomic_t in_critical_section = 0;
+thread_local volatile sig_atomic_t preempt_pending = 0;
 
 
 /// functions ///
@@ -69,534 +195,2751 @@ sigset_t signal_set;
 
 
 /*
- * Description: This function blocks the SIGVTALRM signal
+ * Description: This function enters the library's critical section -
+ * preemption by SIGVTALRM is deferred until unblock_signals. With several
+ * workers it also waits for the other workers to leave theirs.
  */
 void block_signals(){
-    if (sigemptyset(&signal_set)){
-        std::cerr << "system error: sigemptyset error\n";
-        exit(EXIT_FAILURE);
+    in_critical_section = 1;
+    std::atomic_signal_fence(std::memory_order_seq_cst);
+    if (workers_num > 1) {
+        while (library_lock.test_and_set(std::memory_order_acquire)) {
+            sched_yield();
+        }
     }
+}
 
-    if (sigaddset(&signal_set,SIGVTALRM)){
-        std::cerr << "system error: sigaddset - SIGVTALRM error\n";
-        exit(EXIT_FAILURE);
-    }
+void contact_switch(int sig);
+void run_deferred_calls();
 
-    if (sigprocmask(SIG_BLOCK, &signal_set, nullptr) < 0){
-        std::cerr << "system error: sigprocmask - SIG_BLOCK error\n";
-        exit(EXIT_FAILURE);
+/*
+ * Description: This function leaves the critical section, and does the
+ * preemption if SIGVTALRM arrived while in it.
+ */
+void unblock_signals(){
+    std::atomic_signal_fence(std::memory_order_seq_cst);
+    // release the lock first - a SIGVTALRM handler must not wait for it
+    if (workers_num > 1) {
+        library_lock.clear(std::memory_order_release);
+        run_deferred_calls();
+    }
+    in_critical_section = 0;
+    std::atomic_signal_fence(std::memory_order_seq_cst);
+    if (preempt_pending){
+        block_signals();
+        preempt_pending = 0;
+        running_dest = 1;
+        contact_switch(SIGVTALRM);
     }
 }
 
 /*
- * Description: This function unblocks the SIGVTALRM signal
+ * Description: This function checks if the quanta are measured by
+ * setitimer(ITIMER_VIRTUAL) - the default clock with one worker - rather
+ * than by a timer_create timer of each worker.
  */
-void unblock_signals(){
-    if (sigprocmask(SIG_UNBLOCK, &signal_set, nullptr) < 0){
-        std::cerr << "system error: sigprocmask - SIG_UNBLOCK error\n";
-        exit(EXIT_FAILURE);
+bool uses_itimer() {
+    return (preemption_clock == UTHREAD_CLOCK_VIRTUAL) && (workers_num == 1);
+}
+
+/*
+ * Description: This function programs the timer of this worker to expire
+ * every quantum_ns, or only once at deadline_ns if it isn't 0 (an absolute
+ * time of the timer's clock). A quantum_ns of 0 stops it. ITIMER_VIRTUAL
+ * rounds the quantum up to microseconds.
+ * Return value: On success, return 0. On failure, return -1.
+ */
+int program_timer(long quantum_ns, unsigned long deadline_ns) {
+    if (uses_itimer()) {
+        long quantum_usecs = (quantum_ns + 999) / 1000;
+        struct itimerval timer;
+        timer.it_value.tv_sec = quantum_usecs / 1000000;
+        timer.it_value.tv_usec = quantum_usecs % 1000000;
+        timer.it_interval = timer.it_value;
+        return setitimer(ITIMER_VIRTUAL, &timer, nullptr);
     }
+    struct itimerspec spec;
+    spec.it_interval.tv_sec = quantum_ns / 1000000000L;
+    spec.it_interval.tv_nsec = quantum_ns % 1000000000L;
+    spec.it_value = spec.it_interval;
+    if (deadline_ns != 0) {
+        spec.it_value.tv_sec = (time_t)(deadline_ns / 1000000000UL);
+        spec.it_value.tv_nsec = (long)(deadline_ns % 1000000000UL);
+        spec.it_interval.tv_sec = 0;
+        spec.it_interval.tv_nsec = 0;
+    }
+    return timer_settime(worker_timer, (deadline_ns != 0) ? TIMER_ABSTIME : 0, &spec, nullptr);
 }
 
 /*
- * Description: This function resets the timer. Each thread get quantum_usecs microseconds.
+ * Description: This function programs the timer of this worker with
+ * armed_quantum_ns and timer_expiry - at once with one worker, and with
+ * several when the critical section ends, outside the library lock.
  */
-void reset_timer(int quantum_usecs) {
-    // Configure the timer to expire after 1 quantum_usecs sec for finishing the running of the main thread
-    timer.it_value.tv_sec = 0;        // first time interval, seconds part
-    timer.it_value.tv_usec = quantum_usecs;        // first time interval, microseconds part
+void update_timer() {
+    if (workers_num > 1) {
+        timer_update_pending = true;
+        return;
+    }
+    if (program_timer(armed_quantum_ns, timer_expiry)) {
+        std::cerr << "thread library error: setitimer error\n";
+    }
+}
 
-    // configure the timer to expire every quantum_usecs sec after that.
-    timer.it_interval.tv_sec = 0;    // following time intervals, seconds part
-    timer.it_interval.tv_usec = quantum_usecs;    // following time intervals, microseconds part
+/*
+ * Description: This function wakes the worker if it sleeps - when the
+ * critical section ends, outside the library lock.
+ */
+void wake_worker(Worker *worker) {
+    workers_to_wake.push_back(worker);
+}
 
-    // Start a virtual timer. It counts down whenever this process is executing.
-    if (setitimer (ITIMER_VIRTUAL, &timer, nullptr)) {
-        std::cerr << "system error: setitimer error\n";
-        unblock_signals();
-        exit(EXIT_FAILURE);
+/*
+ * Description: This function makes the system calls deferred by the
+ * critical section of this worker (M:N mode), once it released the library
+ * lock - it is still in the critical section, so SIGVTALRM only marks the
+ * preemption pending.
+ */
+void run_deferred_calls() {
+    if (timer_update_pending) {
+        timer_update_pending = false;
+        if (program_timer(armed_quantum_ns, timer_expiry)) {
+            std::cerr << "thread library error: setitimer error\n";
+        }
     }
+    for (Worker *worker : workers_to_wake) {
+        worker->wake();
+    }
+    workers_to_wake.clear();
 }
 
 /*
- * Description: This function erases the pointer to the thread with the
- * given tid in the given map.
+ * Description: This function stops the timer of this worker.
  */
-void erase_from_map(int tid, int which_map) {
-    map<int, Thread*>::iterator it;
+void stop_timer() {
+    armed_quantum_ns = 0;
+    quantum_deadline = 0;
+    timer_expiry = 0;
+    update_timer();
+}
 
-    if (which_map == READY_MAP)
-    {
-        it = ready_threads_map.find(tid);
-        ready_threads_map.erase(it);
+/*
+ * Description: This function makes the next quantum that starts on this
+ * worker a whole one - the timer is restarted for it (see arm_quantum).
+ */
+void restart_quantum() {
+    restart_pending = true;
+}
+
+/*
+ * Description: This function returns the CPU time of this worker (kernel
+ * thread), in nanoseconds.
+ */
+unsigned long worker_cpu_time() {
+    struct timespec now;
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &now);
+    return (unsigned long)now.tv_sec * 1000000000UL + (unsigned long)now.tv_nsec;
+}
+
+/*
+ * Description: This function returns the time of CLOCK_MONOTONIC, in
+ * nanoseconds.
+ */
+unsigned long monotonic_time() {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (unsigned long)now.tv_sec * 1000000000UL + (unsigned long)now.tv_nsec;
+}
+
+/*
+ * Description: This function charges the thread for the CPU time since the
+ * last charge on this worker (for the policy, and the budgets of periodic
+ * threads) and returns it - thread is nullptr (or the idle thread) to just
+ * start a new charge. The caller passes the time to the policy's on_tick or
+ * on_block.
+ */
+unsigned long charge_run_time(Thread *thread) {
+    if (!run_time_measured) {
+        return 0;
     }
-    else {
-        it = blocked_threads.find(tid);
-        blocked_threads.erase(it);
+    unsigned long now = worker_cpu_time();
+    unsigned long run_time = now - run_start;
+    run_start = now;
+    if ((thread == nullptr) || (thread->get_tid() == IDLE_TID)) {
+        return 0;
     }
+    thread->add_run_time(run_time);
+    if (thread->get_reservation() != nullptr) {
+        thread->get_reservation()->charge(run_time);
+    }
+    return run_time;
 }
 
 /*
- * Description: if running_dest == 1 -> ready, if running_dest == 2 -> blocked
- * and if running_dest == 3 -> terminate
+ * Description: This function puts the thread in the ready queue of this
+ * worker, by the policy (periodic threads in edf_threads).
  */
-void contact_switch(int sig)
-{
-    if (ready_threads_map.empty()) {
+void push_ready(Thread *thread) {
+    thread->set_state(READY);
+    thread->next_ready_ticket();
+    thread->set_ready_entries(thread->get_ready_entries() + 1);
+    if (sched_stats) {
+        thread->set_ready_time(monotonic_time());
+    }
+    if (thread->get_reservation() != nullptr) {
+        edf_threads.push(thread);
+        return;
+    }
+    POLICY_HOOK(enqueue, *this_worker, thread);
+}
+
+/*
+ * Description: This function wakes a sleeping worker (if any), to steal
+ * from the ready queue of this worker.
+ */
+void wake_sleeping_worker() {
+    for (int i = 0; i < workers_num; i++) {
+        if ((workers[i] != this_worker) && workers[i]->is_sleeping()) {
+            wake_worker(workers[i]);
+            return;
+        }
+    }
+}
+
+/*
+ * Description: This function wakes the worker of a running thread that
+ * waited with nothing else to run (see idle_wait), if it is another worker.
+ */
+void wake_waiting_worker(const Thread *thread) {
+    Worker *worker = workers[thread->get_worker()];
+    if (worker != this_worker) {
+        wake_worker(worker);
+    }
+}
 
-        //insert the main thread to the ready map and deque
-        if (running_thread_ptr->get_tid() == 0)
-        {
-            ready_threads_map.insert({running_thread_ptr->get_tid(), running_thread_ptr});
-            ordered_deque_threads.push_back(running_thread_ptr);
+void arm_quantum(const Thread *thread);
+
+/*
+ * Description: This function makes the thread ready - it joins the ready
+ * queue of this worker, and a sleeping worker (if any) is woken to steal it.
+ * If it is more urgent than the running thread (by the policy), the running
+ * thread is preempted when the critical section ends (and its timer is
+ * restarted, if it was stopped in tickless mode). A periodic thread is more
+ * urgent than all the others, and than the periodic threads with later
+ * deadlines.
+ */
+void make_ready(Thread *thread) {
+    Reservation *running_reservation = running_thread_ptr->get_reservation();
+    if (thread->get_reservation() != nullptr) {
+        push_ready(thread);
+        wake_sleeping_worker();
+        if ((running_reservation == nullptr) ||
+            (thread->get_reservation()->get_deadline() < running_reservation->get_deadline())) {
+            preempt_pending = 1;
         }
+        return;
+    }
+    POLICY_HOOK(on_wake, *this_worker, thread);
+    push_ready(thread);
+    wake_sleeping_worker();
+    Thread *running = running_thread_ptr;
+    if ((running_reservation != nullptr) || (running->get_tid() == IDLE_TID)) {
+        return;
+    }
+    if (armed_quantum_ns == 0) {
+        // tickless - the running thread no longer runs alone
+        arm_quantum(running);
+    }
+    POLICY_HOOK(on_tick, running, charge_run_time(running));
+    if (POLICY_HOOK(should_preempt, thread, running)) {
+        preempt_pending = 1;
+    }
+}
 
-        total_quantum++;
-        running_thread_ptr->set_quantum_running_time(running_thread_ptr->get_quantum_running_time() + 1);
-        unblock_signals();
-        siglongjmp(running_thread_ptr->env[0],1);
+/*
+ * Description: This function makes a ready thread not ready - its entry in
+ * a ready queue becomes stale, and is skipped when it is taken.
+ */
+void make_unready(Thread *thread, int state) {
+    if (thread->get_state() == READY) {
+        thread->next_ready_ticket();
     }
+    thread->set_state(state);
+}
 
-    if (running_dest == 3) {
-        running_dest = 1;
-        total_quantum++;
-        running_thread_ptr->set_quantum_running_time(running_thread_ptr->get_quantum_running_time() + 1);
-        // Changing the env of the running thread
-        siglongjmp(running_thread_ptr->env[0], 1); // jump to the new thread sp & pc
+/*
+ * Description: This function releases a terminated thread to the pool. A
+ * thread that still has entries in the ready deques is released when the
+ * last of them is taken.
+ */
+void release_thread(Thread *thread) {
+    if (thread->get_ready_entries() > 0) {
+        thread->next_ready_ticket();
+        thread->set_state(TERMINATED);
+        return;
     }
+    threads_pool.release(thread);
+}
 
-    if (running_dest == 2){
-        // The running thread that we want to block
-        Thread *to_block_thread = running_thread_ptr;
-        // The first thread in the ready deque -> make it the running thread
-        Thread *thread_to_run = ordered_deque_threads.front();
-        ordered_deque_threads.pop_front();
-        erase_from_map(thread_to_run->get_tid(), READY_MAP);
-        // Making the first thread in the ready deque, the running thread
-        thread_to_run->set_state(RUNNING);
-        running_thread_ptr = thread_to_run;
-        // blocked the prev running thread
-        blocked_threads.insert({to_block_thread->get_tid(), to_block_thread});
-        to_block_thread->set_blocked_by_thread(BLOCKED);
-        running_dest = 1;
+/*
+ * Description: This function accounts for an entry of the thread taken from
+ * a ready deque, and returns true if the thread should run - false if the
+ * entry was stale (its ticket is not the thread's current one).
+ */
+bool claim_ready_thread(Thread *thread, unsigned long ticket) {
+    thread->set_ready_entries(thread->get_ready_entries() - 1);
+    if ((thread->get_state() != READY) || (ticket != thread->get_ready_ticket())) {
+        if ((thread->get_state() == TERMINATED) && (thread->get_ready_entries() == 0)) {
+            threads_pool.release(thread);
+        }
+        return false;
+    }
+    return true;
+}
 
-        // save the prev env & set the env of the new running thread
-        int ret_val = sigsetjmp(to_block_thread->env[0],1);
-        if (ret_val == 1) {
-            unblock_signals();
-            return;
+/*
+ * Description: This function takes the next thread to run - the periodic
+ * thread with the earliest deadline, or else the policy's next thread of
+ * this worker - nullptr if there is none.
+ */
+Thread *pop_ready_thread() {
+    while (true) {
+        unsigned long ticket;
+        Thread *thread = edf_threads.pop(&ticket);
+        if (thread == nullptr) {
+            thread = POLICY_HOOK(pick_next, *this_worker, &ticket);
+        }
+        if ((thread == nullptr) || claim_ready_thread(thread, ticket)) {
+            return thread;
+        }
+    }
+}
+
+/*
+ * Description: This function takes the periodic thread with the earliest
+ * deadline - nullptr if there is none.
+ */
+Thread *pop_periodic_thread() {
+    while (true) {
+        unsigned long ticket;
+        Thread *thread = edf_threads.pop(&ticket);
+        if ((thread == nullptr) || claim_ready_thread(thread, ticket)) {
+            return thread;
         }
-        total_quantum++;
-        running_thread_ptr->set_quantum_running_time(running_thread_ptr->get_quantum_running_time() + 1);
+    }
+}
+
+/*
+ * Description: This function steals a thread (and the ticket of its entry)
+ * from the ready queue of another worker, nullptr if they are all empty. It
+ * is called outside the critical section - the thread must be claimed
+ * (claim_ready_thread) in it. It enters the critical section meanwhile if
+ * the policy's queues are not lock-free.
+ */
+Thread *steal_ready_thread(unsigned long *ticket) {
+    bool locked = POLICY_HOOK(locked_steal);
+    if (locked) {
+        block_signals();
+    }
+    int my_id = this_worker->get_id();
+    Thread *stolen = nullptr;
+    for (int i = 1; (i < workers_num) && (stolen == nullptr); i++) {
+        stolen = POLICY_HOOK(steal, *workers[(my_id + i) % workers_num], *this_worker, ticket);
+    }
+    if (locked) {
         unblock_signals();
-        siglongjmp(running_thread_ptr->env[0],1);
     }
+    return stolen;
+}
+
+/*
+ * Description: This function puts the periodic thread in release_queue,
+ * until the period that its reservation's get_release_time starts.
+ */
+void wait_release(Thread *thread) {
+    unsigned long release_time = thread->get_reservation()->get_release_time();
+    Thread *position = release_queue.front();
+    while ((position != nullptr) && (position->get_reservation()->get_release_time() <= release_time)) {
+        position = release_queue.next(position);
+    }
+    thread->set_waiting_release(true);
+    release_queue.insert_before(position, thread);
+    next_release.store(release_queue.front()->get_reservation()->get_release_time());
+}
 
-    if (running_dest == 1) {
-        // The running thread that we want to make ready
-        Thread *to_ready_thread = running_thread_ptr;
+/*
+ * Description: This function releases the periodic threads whose period
+ * started - they become ready, unless they are blocked (or still running,
+ * since nothing else was ready).
+ */
+void release_periodic_threads() {
+    if (release_queue.empty()) {
+        return;
+    }
+    unsigned long now = monotonic_time();
+    while (!release_queue.empty() && (release_queue.front()->get_reservation()->get_release_time() <= now)) {
+        Thread *thread = release_queue.pop_front();
+        thread->get_reservation()->release();
+        thread->set_waiting_release(false);
+        if (!thread->get_blocked_by_thread() && (thread->get_state() == WAITING)) {
+            push_ready(thread);
+            wake_sleeping_worker();
+        }
+        else if (thread->get_state() == RUNNING) {
+            wake_waiting_worker(thread);
+        }
+    }
+    next_release.store(release_queue.empty() ? 0 : release_queue.front()->get_reservation()->get_release_time());
+}
 
-        Thread *thread_to_run;
-        if ((ordered_deque_threads.front() ==  running_thread_ptr) && (ready_threads_map.size() > 1)){
-            thread_to_run = ordered_deque_threads.front();
-            ordered_deque_threads.pop_front();
-            erase_from_map(thread_to_run->get_tid(), READY_MAP);
+/*
+ * Description: This function wakes up the sleeping threads whose wake time
+ * passed - they become ready, unless they are blocked (or still running,
+ * since nothing else was ready).
+ */
+void wake_sleeping_threads() {
+    if (sleeping_threads.empty()) {
+        return;
+    }
+    ThreadQueue woken;
+    sleeping_threads.advance(monotonic_time(), woken);
+    while (!woken.empty()) {
+        Thread *thread = woken.pop_front();
+        thread->set_wake_time(0);
+        if (!thread->get_blocked_by_thread() && (thread->get_state() == WAITING)) {
+            POLICY_HOOK(on_wake, *this_worker, thread);
+            push_ready(thread);
+            wake_sleeping_worker();
+        }
+        else if (thread->get_state() == RUNNING) {
+            wake_waiting_worker(thread);
         }
+    }
+    next_wakeup.store(sleeping_threads.next_expiry());
+}
 
-        // The first thread in the ready deque -> make it the running thread
-        thread_to_run = ordered_deque_threads.front();
-        ordered_deque_threads.pop_front();
-        erase_from_map(thread_to_run->get_tid(), READY_MAP);
-        // Making the first thread in the ready deque, the running thread
-        thread_to_run->set_state(RUNNING);
-        running_thread_ptr = thread_to_run;
+/*
+ * Description: This function returns the quantum the thread runs with on
+ * this worker, in nanoseconds - its own, or else the library's. In adaptive mode the
+ * library's quantum is ADAPTIVE_QUANTUM_SCALE quanta divided by the number
+ * of ready threads, rounded up to a power of 2 so it changes (and the timer
+ * is reprogrammed) only when the number of threads doubles or halves.
+ * Wall-clock quanta are at least MIN_WALL_QUANTUM_NS.
+ */
+long thread_quantum(const Thread *thread) {
+    long quantum_ns = library_quantum_ns;
+    if (thread->get_quantum_usecs() != 0) {
+        quantum_ns = thread->get_quantum_usecs() * 1000L;
+    }
+    else if (adaptive_quantum) {
+        long ready = POLICY_HOOK(queued, *this_worker);
+        int shift = (ready > 1) ? 64 - __builtin_clzll((unsigned long long)(ready - 1)) : 0;
+        // 1 ready thread: 4 quanta, 2: 2 quanta, 3-4: 1 quantum, ..., 9 and more: 1/4 quantum
+        shift = std::min(shift, 4);
+        quantum_ns = std::max(library_quantum_ns * ADAPTIVE_QUANTUM_SCALE >> shift, 1L);
+    }
+    if (preemption_clock == UTHREAD_CLOCK_MONOTONIC) {
+        quantum_ns = std::max(quantum_ns, MIN_WALL_QUANTUM_NS);
+    }
+    return quantum_ns;
+}
+
+/*
+ * Description: This function checks if the thread runs alone on this worker
+ * - no other thread is ready on it, and no periodic (or sleeping) thread
+ * may need to preempt it (tickless mode stops the timer then).
+ */
+bool runs_alone(const Thread *thread) {
+    return (POLICY_HOOK(queued, *this_worker) == 0) && edf_threads.empty() &&
+           (next_release.load() == 0) && (next_wakeup.load() == 0) && (thread->get_reservation() == nullptr);
+}
+
+/*
+ * Description: This function programs the timer of this worker with the
+ * quantum of the thread, if it isn't programmed with it already or a whole
+ * quantum was requested (the timer then restarts) - or stops it, in
+ * tickless mode, if the thread runs alone. A UTHREAD_CLOCK_MONOTONIC quantum
+ * always ends quantum_ns after it starts: a timer that expires before that
+ * is left alone, and reset_clock moves it to quantum_deadline.
+ */
+void arm_quantum(const Thread *thread) {
+    long quantum_ns = (tickless && runs_alone(thread)) ? 0 : thread_quantum(thread);
+    bool keep = !restart_pending && (quantum_ns == armed_quantum_ns);
+    unsigned long deadline = 0;
+    if ((preemption_clock == UTHREAD_CLOCK_MONOTONIC) && (quantum_ns != 0)) {
+        unsigned long now = monotonic_time();
+        deadline = now + quantum_ns;
+        quantum_deadline = deadline;
+        keep = (quantum_ns == armed_quantum_ns) && (timer_expiry > now) && (timer_expiry <= deadline);
+    }
+    restart_pending = false;
+    if (keep) {
+        return;
+    }
+    armed_quantum_ns = quantum_ns;
+    quantum_deadline = deadline;
+    timer_expiry = deadline;
+    update_timer();
+}
+
+/*
+ * Description: This function counts a new quantum of the thread (the idle
+ * threads of the workers are not counted), programs the timer for it, and
+ * samples the time it waited since it became ready.
+ */
+void start_quantum(Thread *thread) {
+    if (thread->get_tid() == IDLE_TID) {
+        return;
+    }
+    total_quantum++;
+    thread->set_quantum_running_time(thread->get_quantum_running_time() + 1);
+    arm_quantum(thread);
+    if (sched_stats && (thread->get_ready_time() != 0)) {
+        unsigned long latency = monotonic_time() - thread->get_ready_time();
+        thread->set_ready_time(0);
+        latency_samples++;
+        latency_total += latency;
+        latency_max = std::max(latency_max, latency);
+    }
+}
+
+/*
+ * Description: This function returns the thread with the given tid,
+ * nullptr if no such thread exists (or it terminated, and only waits to be
+ * joined).
+ */
+Thread* get_thread(int tid) {
+    Thread *thread = threads_table.get(tid);
+    if ((thread != nullptr) && (thread->get_state() == ZOMBIE)) {
+        return nullptr;
+    }
+    return thread;
+}
+
+/*
+ * Description: This function returns the mutex object stored in the
+ * storage of a uthread_mutex_t.
+ */
+Mutex* get_mutex(uthread_mutex_t *mutex) {
+    static_assert(sizeof(Mutex) <= sizeof(uthread_mutex_t), "uthread_mutex_t is too small");
+    return reinterpret_cast<Mutex*>(mutex->storage);
+}
+
+/*
+ * Description: This function returns the condition variable object stored
+ * in the storage of a uthread_cond_t.
+ */
+CondVar* get_cond(uthread_cond_t *cond) {
+    static_assert(sizeof(CondVar) <= sizeof(uthread_cond_t), "uthread_cond_t is too small");
+    return reinterpret_cast<CondVar*>(cond->storage);
+}
+
+/*
+ * Description: This function wakes a thread whose wait ended (a mutex was
+ * handed to it, ...) - it moves to the ready queue, unless it is blocked.
+ */
+void wake_waiter(Thread *blocked_to_ready) {
+    // a waiter that found nothing else to run is still running, and its
+    // worker may sleep in idle_wait
+    if (!blocked_to_ready->get_blocked_by_thread() && blocked_to_ready->get_state() != RUNNING) {
+        make_ready(blocked_to_ready);
+    }
+    else if (blocked_to_ready->get_state() == RUNNING) {
+        wake_waiting_worker(blocked_to_ready);
+    }
+}
+
+/*
+ * Description: These functions return the objects stored in the storage of
+ * a uthread_sem_t, uthread_barrier_t, uthread_latch_t, uthread_waitgroup_t
+ * (a wait group is a Latch whose count may go up) and uthread_rwlock_t.
+ */
+Semaphore* get_sem(uthread_sem_t *sem) {
+    static_assert(sizeof(Semaphore) <= sizeof(uthread_sem_t), "uthread_sem_t is too small");
+    return reinterpret_cast<Semaphore*>(sem->storage);
+}
+
+Barrier* get_barrier(uthread_barrier_t *barrier) {
+    static_assert(sizeof(Barrier) <= sizeof(uthread_barrier_t), "uthread_barrier_t is too small");
+    return reinterpret_cast<Barrier*>(barrier->storage);
+}
+
+Latch* get_latch(uthread_latch_t *latch) {
+    static_assert(sizeof(Latch) <= sizeof(uthread_latch_t), "uthread_latch_t is too small");
+    return reinterpret_cast<Latch*>(latch->storage);
+}
+
+Latch* get_waitgroup(uthread_waitgroup_t *group) {
+    static_assert(sizeof(Latch) <= sizeof(uthread_waitgroup_t), "uthread_waitgroup_t is too small");
+    return reinterpret_cast<Latch*>(group->storage);
+}
 
-        // ready the prev running thread
-        if (sig != 120) {
-            ready_threads_map.insert({to_ready_thread->get_tid(), to_ready_thread});
-            ordered_deque_threads.push_back(to_ready_thread);
-            to_ready_thread->set_state(READY);
+RWLock* get_rwlock(uthread_rwlock_t *rwlock) {
+    static_assert(sizeof(RWLock) <= sizeof(uthread_rwlock_t), "uthread_rwlock_t is too small");
+    return reinterpret_cast<RWLock*>(rwlock->storage);
+}
+
+/*
+ * Description: This function hands the unlocked mutex to a thread that
+ * waits for it (and is no longer in any queue), which moves to the ready
+ * queue - so it never wakes up to find the mutex taken again.
+ */
+void hand_mutex(Mutex *mutex, Thread *blocked_to_ready) {
+    blocked_to_ready->set_blocked_by_mutex(false);
+    mutex->acquire(blocked_to_ready);
+    wake_waiter(blocked_to_ready);
+}
+
+/*
+ * Description: This function wakes a thread that waits on a semaphore,
+ * barrier, latch, wait group or reader-writer lock (and is no longer in its
+ * queue).
+ */
+void wake_sync_waiter(Thread *blocked_to_ready) {
+    blocked_to_ready->set_blocked_by_sync(false);
+    wake_waiter(blocked_to_ready);
+}
+
+/*
+ * Description: This function wakes all the threads of a queue of waiters of
+ * a barrier, latch, wait group or reader-writer lock.
+ */
+void wake_sync_waiters(ThreadQueue &waiters) {
+    while (!waiters.empty()) {
+        wake_sync_waiter(waiters.pop_front());
+    }
+}
+
+/*
+ * Description: This function releases the mutex. If threads wait for it, the
+ * ownership is handed directly to the first of them.
+ */
+void release_mutex(Mutex *mutex) {
+    mutex->release(get_thread(mutex->get_owner()));
+    ThreadQueue &waiters = mutex->get_waiters();
+    if (!waiters.empty()) {
+        hand_mutex(mutex, waiters.pop_front());
+    }
+}
+
+/*
+ * Description: This function moves a signalled waiter of a condition
+ * variable (no longer in its queue) to the waiters of the mutex - or hands
+ * it the mutex, if it is unlocked (wait morphing).
+ */
+void morph_cond_waiter(Mutex *mutex, Thread *thread) {
+    if (!mutex->is_locked()) {
+        hand_mutex(mutex, thread);
+        return;
+    }
+    mutex->get_waiters().push_back(thread);
+}
+
+/*
+ * Description: This function releases all the mutexes and reader-writer
+ * locks the thread holds.
+ */
+void release_held_mutexes(Thread *thread) {
+    while (thread->get_held_mutexes() != nullptr) {
+        release_mutex(thread->get_held_mutexes());
+    }
+    while (thread->get_held_rwlock() != nullptr) {
+        ThreadQueue woken;
+        thread->get_held_rwlock()->release(thread, woken);
+        wake_sync_waiters(woken);
+    }
+}
+
+/*
+ * Description: This function gives the result of the terminating thread to
+ * the thread that waits to join it (if any), which moves to the ready
+ * queue. It returns true if the thread should be kept until it is joined -
+ * it is joinable and no thread waits for it yet.
+ */
+bool finish_joinable(Thread *thread, void *result) {
+    if (thread->get_detached()) {
+        return false;
+    }
+    Thread *joiner = thread->get_joiner();
+    if (joiner == nullptr) {
+        thread->set_result(result);
+        return true;
+    }
+    if (joiner->get_join_result() != nullptr) {
+        *joiner->get_join_result() = result;
+    }
+    joiner->set_joining(nullptr, nullptr);
+    wake_waiter(joiner);
+    return false;
+}
+
+void idle_wait();
+
+/*
+ * Description: This function stops the running thread, which is in a queue
+ * of waiters, until the mutex is handed to it. It is called in the critical
+ * section.
+ */
+void wait_for_mutex(Mutex *mutex) {
+    running_thread_ptr->set_blocked_by_mutex(true);
+    restart_quantum();
+    // with nothing else to run contact_switch returns at once - sleep until
+    // the owner hands us the mutex
+    while (true) {
+        running_dest = 1;
+        contact_switch(120);
+        block_signals();
+        if (mutex->get_owner() == running_thread_ptr->get_tid()) {
+            break;
         }
+        idle_wait();
+    }
+}
+
+/*
+ * Description: This function stops the running thread, which is in the
+ * queue of waiters of a semaphore, barrier, latch, wait group or
+ * reader-writer lock, until wake_sync_waiter wakes it. It is called in the critical section.
+ */
+void wait_for_sync() {
+    running_thread_ptr->set_blocked_by_sync(true);
+    restart_quantum();
+    // with nothing else to run contact_switch returns at once - sleep until
+    // we are woken
+    while (true) {
         running_dest = 1;
-        // save the prev env & set the env of the new running thread
-        int ret_val = sigsetjmp(to_ready_thread->env[0],1);
-        if (ret_val == 1) {
-            unblock_signals();
-            return;
+        contact_switch(120);
+        block_signals();
+        if (!running_thread_ptr->get_blocked_by_sync()) {
+            break;
         }
-        total_quantum++;
-        running_thread_ptr->set_quantum_running_time(running_thread_ptr->get_quantum_running_time() + 1);
-        unblock_signals();
-        siglongjmp(running_thread_ptr->env[0],1);
+        idle_wait();
     }
 }
 
 /*
- * Description: This function resets the running_dest flag to 1 ->
- * for contact switch to ready position.
+ * Description: This function tries to acquire the mutex, see uthread_mutex_lock.
+ * func is the name of the calling library function, for the error messages.
  */
-void reset_clock(int sig){
-    running_dest = 1;
-    contact_switch(SIGVTALRM);
+int lock_mutex(Mutex *mutex, const char *func) {
+    block_signals();
+
+    // The mutex is available
+    if (!mutex->is_locked()){
+        mutex->acquire(running_thread_ptr);
+        unblock_signals();
+        return SUCCESS
+    }
+
+    // If the mutex is already locked by this Thread, it is considered an error
+    if (mutex->get_owner() == running_thread_ptr->get_tid())
+    {
+        std::cerr << "thread library error: error in " << func << " - "
+                     "thread tries to lock itself\n";
+        unblock_signals();
+        return FAILURE
+    }
+
+    // Wait in the queue - the unlocking thread hands the mutex to us
+    mutex->get_waiters().push_back(running_thread_ptr);
+    wait_for_mutex(mutex);
+    unblock_signals();
+    return SUCCESS
+}
+
+/*
+ * Description: This function adds delta to the count of the latch (or wait
+ * group), and wakes its waiters if it reached zero. It is an error to make
+ * the count negative. func is the name of the calling library function, for
+ * the error messages.
+ */
+int add_to_latch(Latch *latch, long delta, const char *func) {
+    block_signals();
+    if (!latch->add(delta)){
+        unblock_signals();
+        std::cerr << "thread library error: error in " << func << " - the count would be negative\n";
+        return FAILURE
+    }
+    if (latch->get_count() == 0){
+        wake_sync_waiters(latch->get_waiters());
+    }
+    unblock_signals();
+    return SUCCESS
+}
+
+/*
+ * Description: This function waits until the count of the latch (or wait
+ * group) is zero.
+ */
+int wait_latch(Latch *latch) {
+    block_signals();
+    if (latch->get_count() != 0){
+        latch->get_waiters().push_back(running_thread_ptr);
+        wait_for_sync();
+    }
+    unblock_signals();
+    return SUCCESS
+}
+
+/*
+ * Description: This function releases the mutex, see uthread_mutex_unlock.
+ * func is the name of the calling library function, for the error messages.
+ */
+int unlock_mutex(Mutex *mutex, const char *func) {
+    block_signals();
+
+    // If the mutex is already unlocked, it is considered an error.
+    if (!mutex->is_locked()){
+        std::cerr << "thread library error: error in " << func << " - "
+                     "unlocking thread that is already unlocked\n";
+        unblock_signals();
+        return FAILURE
+    }
+
+    if (running_thread_ptr->get_tid() != mutex->get_owner())
+    {
+        std::cerr << "thread library error: error in " << func << " - "
+                     "the mutex has been unlocked by another thread\n";
+        unblock_signals();
+        return FAILURE
+    }
+
+    release_mutex(mutex);
+    unblock_signals();
+    return SUCCESS
+}
+
+/*
+ * Description: This function creates a new thread with the given stack size
+ * (without the signal frame reserve), and makes it ready. A periodic thread
+ * gets its reservation, and its first job is released now.
+ * Return value: On success, return the ID of the created Thread.
+ * On failure, return -1.
+ */
+int spawn_thread(void (*f)(void), int stack_size, Reservation *reservation) {
+    // the new thread gets the minimal available id
+    int tid = threads_table.allocate_tid();
+    if (tid < 0){
+        std::cerr << "thread library error: error in uthread_spawn function\n";
+        return FAILURE
+    }
+    Thread *new_thread = threads_pool.acquire(tid, f, stack_size + signal_frame_reserve);
+    if (new_thread == nullptr){
+        threads_table.release(tid);
+        std::cerr << "thread library error: error in uthread_spawn function - "
+                     "no memory for the stack\n";
+        return FAILURE
+    }
+    threads_table.insert(new_thread);
+    new_thread->set_blocked_by_thread(UNBLOCKED);
+    if (reservation != nullptr) {
+        new_thread->set_reservation(reservation);
+        reservation->start(monotonic_time());
+    }
+    make_ready(new_thread);
+    return tid;
+}
+
+/*
+ * Description: This function returns the stack size attrs give a new
+ * thread (see uthread_spawn_ex).
+ * Return value: On success, return the stack size. On failure, return -1.
+ */
+int attrs_stack_size(const uthread_attr_t *attrs) {
+    int stack_size = STACK_SIZE;
+    if ((attrs != nullptr) && (attrs->stack_size != 0)){
+        stack_size = attrs->stack_size;
+    }
+    if (stack_size < MIN_STACK_SIZE){
+        std::cerr << "thread library error: stack size is smaller than MIN_STACK_SIZE\n";
+        return FAILURE
+    }
+    return stack_size;
+}
+
+/*
+ * Description: This function releases the tid of a terminated thread.
+ */
+void free_tid(int tid) {
+    threads_table.release(tid);
+}
+
+/*
+ * Description: This function returns how many bytes the kernel may need on
+ * a thread's stack to deliver SIGVTALRM (large on CPUs with big vector
+ * register files). It is added to every thread's stack.
+ */
+int get_signal_frame_size() {
+    long size = MINSIGSTKSZ;
+#ifdef AT_MINSIGSTKSZ
+    long kernel_size = (long)getauxval(AT_MINSIGSTKSZ);
+    if (kernel_size > size) {
+        size = kernel_size;
+    }
+#endif
+    return (int)((size + 15) & ~15L);
+}
+
+/*
+ * Description: This function is the SIGSEGV handler. If the fault is in the
+ * guard page of the running thread's stack it reports the overflow. Either
+ * way the default action is restored, so the faulting access kills the
+ * process when the handler returns.
+ */
+void stack_overflow_handler(int sig, siginfo_t *info, void *context){
+    (void)context;
+    if ((running_thread_ptr != nullptr) && running_thread_ptr->in_guard_page(info->si_addr)){
+        const char message[] = "thread library error: stack overflow\n";
+        if (write(STDERR_FILENO, message, sizeof(message) - 1) < 0){
+            // nothing to do - the process is about to die anyway
+        }
+    }
+    signal(sig, SIG_DFL);
+}
+
+/*
+ * Description: This function gives the calling kernel thread an alternate
+ * signal stack for stack_overflow_handler. The stack is mapped on the first
+ * call, and reused by the next ones.
+ */
+void install_signal_stack() {
+    if (signal_stack.ss_sp == nullptr) {
+        signal_stack.ss_size = round_stack_size(signal_frame_reserve + SIGSTKSZ);
+        void *mapping = mmap(nullptr, signal_stack.ss_size, PROT_READ | PROT_WRITE,
+                             MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+        if (mapping == MAP_FAILED) {
+            std::cerr << "system error: mmap error\n";
+            exit(EXIT_FAILURE);
+        }
+        signal_stack.ss_sp = mapping;
+    }
+    signal_stack.ss_flags = 0;
+    if (sigaltstack(&signal_stack, nullptr) < 0) {
+        std::cerr << "system error: sigaltstack error\n";
+        exit(EXIT_FAILURE);
+    }
+}
+
+/*
+ * Description: This function takes the alternate signal stack of the
+ * calling kernel thread away, and unmaps it.
+ */
+void free_signal_stack() {
+    if (signal_stack.ss_sp == nullptr) {
+        return;
+    }
+    stack_t disabled = {};
+    disabled.ss_flags = SS_DISABLE;
+    sigaltstack(&disabled, nullptr);
+    munmap(signal_stack.ss_sp, signal_stack.ss_size);
+    signal_stack.ss_sp = nullptr;
+}
+
+/*
+ * Description: This function installs stack_overflow_handler on an
+ * alternate signal stack.
+ */
+void install_overflow_handler() {
+    install_signal_stack();
+    overflow_sa.sa_sigaction = &stack_overflow_handler;
+    overflow_sa.sa_flags = SA_SIGINFO | SA_ONSTACK;
+    if (sigaction(SIGSEGV, &overflow_sa, nullptr) < 0) {
+        std::cerr << "system error: sigaction error\n";
+        exit(EXIT_FAILURE);
+    }
+}
+
+/*
+ * Description: This function runs when the process exits (by
+ * uthread_terminate(0), or main returned, or exit was called). The statics
+ * of the library are destroyed after it, so the thread that exits stays in
+ * the critical section - a preemption signal meanwhile only marks the
+ * preemption pending. Its alternate signal stack is freed.
+ */
+void enter_exit_section() {
+    in_critical_section = 1;
+    free_signal_stack();
+}
+
+/*
+ * Description: This function frees the thread that terminated itself (if
+ * any). It is called by the thread that runs after it.
+ */
+void free_terminated_thread() {
+    if (terminated_thread != nullptr) {
+        // stale entries of it may still be queued
+        release_thread(terminated_thread);
+        terminated_thread = nullptr;
+    }
+}
+
+/*
+ * Description: if running_dest == 1 -> ready, if running_dest == 2 -> blocked
+ * and if running_dest == 3 -> terminate
+ */
+void contact_switch(int sig)
+{
+    if (running_dest == 3) {
+        // uthread_terminate already chose the running thread
+        running_dest = 1;
+        charge_run_time(nullptr);
+        switch_count++;
+        start_quantum(running_thread_ptr);
+        // Changing the env of the running thread
+        running_thread_ptr->resume_context(); // jump to the new thread sp & pc
+    }
+
+    if (running_thread_ptr == this_worker->get_idle_thread()) {
+        // a deferred preemption of the idle thread - it runs the next thread itself
+        running_dest = 1;
+        unblock_signals();
+        return;
+    }
+
+    // The running thread that we want to block / make ready
+    Thread *prev_thread = running_thread_ptr;
+    unsigned long run_time = charge_run_time(prev_thread);
+    Reservation *reservation = prev_thread->get_reservation();
+    if ((reservation != nullptr) && reservation->budget_exhausted()) {
+        // the job goes on with the budget of its next period
+        reservation->postpone();
+    }
+    // (it may release prev_thread itself, if it waits for its period)
+    release_periodic_threads();
+    wake_sleeping_threads();
+    // blocked by another worker while it was running
+    bool prev_ready = (running_dest == 1) && (sig != 120) && !prev_thread->get_blocked_by_thread() &&
+                      !prev_thread->get_waiting_release() && (prev_thread->get_wake_time() == 0);
+    if (prev_ready) {
+        POLICY_HOOK(on_tick, prev_thread, run_time);
+    }
+    else {
+        POLICY_HOOK(on_block, prev_thread, run_time);
+    }
+
+    if (prev_ready) {
+        // ready the prev running thread - it goes on if it is still the most urgent
+        push_ready(prev_thread);
+    }
+    // The first thread in the ready queue -> make it the running thread
+    Thread *thread_to_run = pop_ready_thread();
+    if ((thread_to_run == prev_thread) ||
+        ((thread_to_run == nullptr) && (this_worker->get_idle_thread() == nullptr))) {
+        prev_thread->set_state(RUNNING);
+        prev_thread->set_ready_time(0); // it didn't wait
+        start_quantum(running_thread_ptr);
+        // nothing else to run - the running thread simply continues
+        running_dest = 1;
+        unblock_signals();
+        return;
+    }
+
+    if (thread_to_run == nullptr) {
+        thread_to_run = this_worker->get_idle_thread();
+    }
+    thread_to_run->set_state(RUNNING);
+    thread_to_run->set_worker(this_worker->get_id());
+    running_thread_ptr = thread_to_run;
+
+    if (running_dest == 2) {
+        // blocked the prev running thread
+        prev_thread->set_blocked_by_thread(BLOCKED);
+    }
+    if (prev_ready) {
+        // other workers may steal it
+        wake_sleeping_worker();
+        preempt_count++;
+    }
+    else {
+        prev_thread->set_state(WAITING);
+    }
+    if (thread_to_run != this_worker->get_idle_thread()) {
+        switch_count++;
+    }
+    running_dest = 1;
+    start_quantum(running_thread_ptr);
+    // save the prev context & resume the new running thread
+    prev_thread->switch_to(running_thread_ptr);
+    free_terminated_thread();
+    unblock_signals();
+}
+
+/*
+ * Description: This function finds a thread for an idle worker - it steals
+ * one from the other workers, and sleeps until it is woken (after
+ * seen_wakeups, read in the critical section), a periodic thread is due to
+ * be released (or a sleeping thread to wake up) or a signal arrives, if
+ * there is none. It returns the stolen
+ * thread, nullptr if it was woken. It is called outside the critical
+ * section.
+ */
+Thread *steal_or_sleep(unsigned long *ticket, int seen_wakeups){
+    Thread *stolen = steal_ready_thread(ticket);
+    if (stolen != nullptr) {
+        return stolen;
+    }
+    // announce the sleep before the last look, so a worker that makes a
+    // thread ready after it sees the announcement and wakes us
+    this_worker->set_sleeping(true);
+    stolen = steal_ready_thread(ticket);
+    if (stolen == nullptr) {
+        // wake up for the first release of a periodic thread, or the first
+        // sleeping thread, if there is one
+        struct timespec timeout;
+        struct timespec *until_release = nullptr;
+        unsigned long release_time = next_release.load();
+        unsigned long wakeup_time = next_wakeup.load();
+        if ((release_time == 0) || ((wakeup_time != 0) && (wakeup_time < release_time))) {
+            release_time = wakeup_time;
+        }
+        if (release_time != 0) {
+            unsigned long now = monotonic_time();
+            unsigned long left = (release_time > now) ? release_time - now : 0;
+            timeout.tv_sec = (time_t)(left / 1000000000UL);
+            timeout.tv_nsec = (long)(left % 1000000000UL);
+            until_release = &timeout;
+        }
+        this_worker->wait(seen_wakeups, until_release);
+    }
+    this_worker->set_sleeping(false);
+    return stolen;
+}
+
+/*
+ * Description: This function parks the kernel thread of this worker while
+ * its running thread waits (for a mutex or its next period) and nothing
+ * else is ready on it - a worker without an idle thread would otherwise
+ * spin in contact_switch. It sleeps as in steal_or_sleep, and the thread
+ * that hands the mutex to the waiting thread (or releases it) wakes it. It
+ * is called in the critical section, and leaves it while it sleeps.
+ */
+void idle_wait() {
+    if ((POLICY_HOOK(queued, *this_worker) != 0) || !edf_threads.empty()) {
+        // contact_switch runs it
+        return;
+    }
+    if ((preemption_clock == UTHREAD_CLOCK_MONOTONIC) && (armed_quantum_ns != 0)) {
+        // the wall-clock timer would wake the worker from its sleep
+        stop_timer();
+    }
+    int seen_wakeups = this_worker->get_wakeups();
+    preempt_pending = 0;
+    unblock_signals();
+    unsigned long ticket;
+    Thread *stolen = steal_or_sleep(&ticket, seen_wakeups);
+    block_signals();
+    if ((stolen != nullptr) && claim_ready_thread(stolen, ticket)) {
+        push_ready(stolen);
+    }
+    if (armed_quantum_ns == 0) {
+        // the waiting thread may go on without a switch
+        arm_quantum(running_thread_ptr);
+    }
+}
+
+/*
+ * Description: This function is the loop of the idle thread of a worker
+ * (M:N mode): it runs the threads of the worker's ready deque, steals
+ * threads from the other workers when it is empty, and sleeps when they
+ * are all empty. It runs in the critical section, except while it steals
+ * or sleeps.
+ */
+void worker_loop(){
+    block_signals();
+    Thread *idle_thread = running_thread_ptr;
+    while (true) {
+        free_terminated_thread();
+        release_periodic_threads();
+        wake_sleeping_threads();
+        // with a lock-free policy only the claim of the thread needs the
+        // lock - the worker's own deque is popped outside it, like a steal
+        bool unlocked_pop = !POLICY_HOOK(locked_steal);
+        Thread *thread_to_run = unlocked_pop ? pop_periodic_thread() : pop_ready_thread();
+        if ((thread_to_run == nullptr) && (preemption_clock == UTHREAD_CLOCK_MONOTONIC) &&
+            (armed_quantum_ns != 0) && (POLICY_HOOK(queued, *this_worker) == 0)) {
+            // the wall-clock timer would wake the worker from its sleep
+            stop_timer();
+        }
+        if (thread_to_run == nullptr) {
+            int seen_wakeups = this_worker->get_wakeups();
+            unblock_signals();
+            unsigned long ticket;
+            // only this worker pushes to its deque, so it is empty until the
+            // worker makes a thread ready again
+            Thread *next = unlocked_pop ? POLICY_HOOK(pick_next, *this_worker, &ticket) : nullptr;
+            if (next == nullptr) {
+                next = steal_or_sleep(&ticket, seen_wakeups);
+            }
+            block_signals();
+            if ((next == nullptr) || !claim_ready_thread(next, ticket)) {
+                continue;
+            }
+            thread_to_run = next;
+        }
+        thread_to_run->set_state(RUNNING);
+        thread_to_run->set_worker(this_worker->get_id());
+        running_thread_ptr = thread_to_run;
+        charge_run_time(nullptr);
+        switch_count++;
+        restart_quantum();
+        start_quantum(thread_to_run);
+        idle_thread->switch_to(thread_to_run);
+    }
+}
+
+/*
+ * Description: This function starts the quantum timer of the calling
+ * worker (or of the process, with ITIMER_VIRTUAL) with the quantum of the
+ * library. A worker's timer sends SIGVTALRM to the worker, and measures its
+ * CPU time (the process's with one worker), or the wall-clock time with
+ * UTHREAD_CLOCK_MONOTONIC.
+ */
+void start_timer() {
+    if (!uses_itimer()) {
+        clockid_t clock = (preemption_clock == UTHREAD_CLOCK_MONOTONIC) ? CLOCK_MONOTONIC :
+                          (workers_num > 1) ? CLOCK_THREAD_CPUTIME_ID : CLOCK_PROCESS_CPUTIME_ID;
+        struct sigevent event = {};
+        event.sigev_notify = SIGEV_THREAD_ID;
+        event.sigev_signo = SIGVTALRM;
+        event._sigev_un._tid = (pid_t)syscall(SYS_gettid);
+        if (timer_create(clock, &event, &worker_timer)) {
+            std::cerr << "system error: timer_create error\n";
+            exit(EXIT_FAILURE);
+        }
+    }
+    armed_quantum_ns = library_quantum_ns;
+    if (preemption_clock == UTHREAD_CLOCK_MONOTONIC) {
+        quantum_deadline = monotonic_time() + library_quantum_ns;
+        timer_expiry = quantum_deadline;
+    }
+    if (program_timer(library_quantum_ns, timer_expiry)) {
+        std::cerr << "system error: setitimer error\n";
+        exit(EXIT_FAILURE);
+    }
+}
+
+/*
+ * Description: This function is the start of the kernel thread of a worker
+ * (all but workers[0], which is the main kernel thread). Its idle thread
+ * runs on the kernel thread's own stack.
+ */
+void *worker_main(void *worker){
+    this_worker = (Worker *)worker;
+    install_signal_stack();
+    auto *idle_thread = new Thread(IDLE_TID, nullptr, 0);
+    idle_thread->set_state(RUNNING);
+    running_thread_ptr = idle_thread;
+    this_worker->set_idle_thread(idle_thread);
+    start_timer();
+    worker_loop();
+    return nullptr;
+}
+
+/*
+ * Description: This function gives workers[0], the main kernel thread, an
+ * idle thread - with a stack of its own.
+ */
+void start_main_idle_thread() {
+    auto *idle_thread = new Thread(IDLE_TID, worker_loop, STACK_SIZE + signal_frame_reserve);
+    idle_thread->set_state(WAITING);
+    workers[0]->set_idle_thread(idle_thread);
+}
+
+/*
+ * Description: This function starts the workers of M:N mode. workers[0] is
+ * the main kernel thread, whose idle thread gets a stack of its own.
+ */
+void start_workers() {
+    start_main_idle_thread();
+    for (int i = 1; i < workers_num; i++) {
+        auto *worker = new Worker(i);
+        workers.push_back(worker);
+        pthread_t kernel_thread;
+        if (pthread_create(&kernel_thread, nullptr, &worker_main, worker) != 0) {
+            std::cerr << "system error: pthread_create error\n";
+            exit(EXIT_FAILURE);
+        }
+        worker->set_kernel_thread(kernel_thread);
+    }
+}
+
+/*
+ * Description: This function completes the job of the running periodic
+ * thread, and waits until the next job is released.
+ */
+void wait_next_period() {
+    block_signals();
+    Thread *thread = running_thread_ptr;
+    POLICY_HOOK(on_block, thread, charge_run_time(thread));
+    thread->get_reservation()->complete_job(monotonic_time());
+    wait_release(thread);
+    restart_quantum();
+    // with nothing else to run contact_switch returns at once - sleep until
+    // the release
+    while (true) {
+        running_dest = 1;
+        contact_switch(SIGVTALRM);
+        block_signals();
+        if (!thread->get_waiting_release()) {
+            break;
+        }
+        idle_wait();
+    }
+    unblock_signals();
+}
+
+/*
+ * Description: This function is the first code that runs on a new thread's
+ * stack: it leaves the critical section that switched to the thread and
+ * calls its entry point (once per job, for a periodic thread).
+ */
+void thread_entry(){
+    free_terminated_thread();
+    unblock_signals();
+    if (running_thread_ptr->get_reservation() != nullptr) {
+        // a periodic thread runs its entry point once per job
+        while (true) {
+            running_thread_ptr->get_entry()();
+            wait_next_period();
+        }
+    }
+    if (running_thread_ptr->get_start_routine() != nullptr) {
+        start_routine_t start_routine = running_thread_ptr->get_start_routine();
+        uthread_exit(start_routine(running_thread_ptr->get_arg()));
+    }
+    running_thread_ptr->get_entry()();
+    uthread_terminate(uthread_get_tid());
+}
+
+/*
+ * Description: This function is the SIGVTALRM handler. If the library is in
+ * a critical section the preemption is deferred, otherwise it resets the
+ * running_dest flag to 1 -> for contact switch to ready position. A
+ * UTHREAD_CLOCK_MONOTONIC timer that expires before the quantum ends (it was
+ * restarted meanwhile) is moved to the end of the quantum instead.
+ */
+void reset_clock(int sig, siginfo_t *info, void *context){
+    (void)context;
+    if ((preemption_clock == UTHREAD_CLOCK_MONOTONIC) && (info->si_code == SI_TIMER)) {
+        unsigned long now = monotonic_time();
+        if (quantum_deadline > now) {
+            timer_expiry = quantum_deadline;
+            program_timer(armed_quantum_ns, quantum_deadline);
+            return;
+        }
+        // the quantum ends - the next one programs the timer again
+        quantum_deadline = 0;
+        timer_expiry = 0;
+    }
+    if (in_critical_section){
+        preempt_pending = 1;
+        return;
+    }
+    // an idle worker has nothing to preempt
+    if (running_thread_ptr == this_worker->get_idle_thread()){
+        return;
+    }
+    block_signals();
+    preempt_pending = 0;
+    running_dest = 1;
+    contact_switch(sig);
+}
+
+/*
+ * Description: This function initializes the Thread library.
+ * You may assume that this function is called before any other Thread library
+ * function, and that it is called exactly once. The input to the function is
+ * the length of a quantum in micro-seconds. It is an error to call this
+ * function with non-positive quantum_usecs.
+ * Return value: On success, return 0. On failure, return -1.
+*/
+int uthread_init(int quantum_usecs){
+    return uthread_init_ex(quantum_usecs, nullptr);
+}
+
+
+/*
+ * Description: This function sets the options to their default values
+ * (the values uthread_init uses).
+ * Return value: On success, return 0. On failure, return -1.
+*/
+int uthread_options_init(uthread_options_t *options){
+    if (options == nullptr){
+        std::cerr << "thread library error: options is NULL\n";
+        return FAILURE
+    }
+    options->pool_size = THREAD_POOL_SIZE;
+    options->pool_prewarm = 0;
+    options->yield_keeps_quantum = 0;
+    options->adaptive_quantum = 0;
+    options->sched_stats = 0;
+    options->tickless = 0;
+    options->workers = 1;
+    options->clock = UTHREAD_CLOCK_VIRTUAL;
+    options->quantum_nsecs = 0;
+    options->max_threads = MAX_THREAD_NUM;
+#ifdef UTHREADS_POLICY
+    options->policy = UTHREADS_POLICY::id();
+#else
+    options->policy = UTHREAD_POLICY_PRIORITY;
+#endif
+    return SUCCESS
+}
+
+
+/*
+ * Description: This function initializes the Thread library like
+ * uthread_init, with the given options. options may be NULL for the
+ * default options. It is an error to give a negative pool size, to
+ * prewarm more threads than the pool size, less than one worker, a
+ * policy the library was not built with, an unknown clock, a negative
+ * quantum_nsecs (quantum_usecs is checked only if quantum_nsecs is 0) or
+ * max_threads smaller than 1.
+ * Return value: On success, return 0. On failure, return -1.
+*/
+int uthread_init_ex(int quantum_usecs, const uthread_options_t *options){
+    uthread_options_t default_options;
+    uthread_options_init(&default_options);
+    if (options == nullptr){
+        options = &default_options;
+    }
+    if ((options->pool_size < 0) || (options->pool_prewarm < 0) ||
+        (options->pool_prewarm > options->pool_size)){
+        std::cerr << "thread library error: invalid thread pool options\n";
+        return FAILURE
+    }
+    if (options->workers < 1){
+        std::cerr << "thread library error: invalid number of workers\n";
+        return FAILURE
+    }
+    if (options->max_threads < 1){
+        std::cerr << "thread library error: invalid max_threads\n";
+        return FAILURE
+    }
+#ifdef UTHREADS_POLICY
+    if (options->policy != UTHREADS_POLICY::id()){
+#else
+    if ((options->policy < UTHREAD_POLICY_PRIORITY) || (options->policy > UTHREAD_POLICY_FAIR)){
+#endif
+        std::cerr << "thread library error: invalid scheduling policy\n";
+        return FAILURE
+    }
+    if ((options->clock < UTHREAD_CLOCK_VIRTUAL) || (options->clock > UTHREAD_CLOCK_MONOTONIC)){
+        std::cerr << "thread library error: invalid preemption clock\n";
+        return FAILURE
+    }
+    workers_num = options->workers;
+    workers.push_back(new Worker(0));
+    this_worker = workers[0];
+    block_signals();
+    if (options->quantum_nsecs < 0){
+        unblock_signals();
+        std::cerr << "thread library error: quantum_nsecs is negative\n";
+        return FAILURE
+    }
+    if ((options->quantum_nsecs == 0) && (quantum_usecs <= 0)){
+        unblock_signals();
+        std::cerr << "thread library error: quantum_usecs is non-positive\n";
+        return FAILURE
+    }
+    signal_frame_reserve = get_signal_frame_size();
+    install_overflow_handler();
+    atexit(enter_exit_section);
+    auto *main_thread = new Thread(0, nullptr, 0);
+    main_thread->set_state(RUNNING);
+    main_thread->set_blocked_by_thread(UNBLOCKED);
+    main_thread->set_quantum_running_time(1);
+    running_thread_ptr = main_thread;
+    threads_table.set_max_threads(options->max_threads);
+    threads_table.allocate_tid(); // tid 0
+    threads_table.insert(main_thread);
+    threads_pool.set_max_threads(options->pool_size);
+    threads_pool.reserve(options->pool_prewarm, STACK_SIZE + signal_frame_reserve);
+    yield_keeps_quantum = options->yield_keeps_quantum;
+    preemption_clock = options->clock;
+    library_quantum_ns = (options->quantum_nsecs != 0) ? options->quantum_nsecs : quantum_usecs * 1000L;
+    if (preemption_clock == UTHREAD_CLOCK_MONOTONIC) {
+        library_quantum_ns = std::max(library_quantum_ns, MIN_WALL_QUANTUM_NS);
+    }
+    adaptive_quantum = options->adaptive_quantum;
+    sched_stats = options->sched_stats;
+    tickless = options->tickless;
+    init_time = monotonic_time();
+#ifndef UTHREADS_POLICY
+    scheduling_policy = options->policy;
+#endif
+    POLICY_HOOK(configure, library_quantum_ns);
+    run_time_measured = POLICY_HOOK(measures_run_time);
+    charge_run_time(nullptr);
+
+    total_quantum++;
+
+    // Install contact_switch as the signal handler for SIGVTALRM.
+    sa.sa_sigaction = &reset_clock;
+    // The handler switches threads without returning, so SIGVTALRM must not
+    // stay blocked by the kernel - in_critical_section protects the handler.
+    sa.sa_flags = SA_NODEFER | SA_SIGINFO;
+    if (preemption_clock == UTHREAD_CLOCK_MONOTONIC) {
+        // the wall-clock timer also expires in system calls - restart them
+        sa.sa_flags |= SA_RESTART;
+    }
+    // After quantum seconds, we will change the running thread
+    if (sigaction(SIGVTALRM, &sa, nullptr) < 0) {
+        unblock_signals();
+        std::cerr << "system error: sigaction error\n";
+        exit(EXIT_FAILURE);
+    }
+
+    start_timer();
+    if (workers_num > 1) {
+        start_workers();
+    }
+    unblock_signals();
+    return SUCCESS
+}
+
+
+/*
+ * Description: This function creates a new Thread, whose entry point is the
+ * function f with the signature void f(void). The Thread is added to the end
+ * of the READY threads list. The uthread_spawn function should fail if it
+ * would cause the number of concurrent threads to exceed the limit
+ * (MAX_THREAD_NUM, or the max_threads option of uthread_init_ex). Each
+ * Thread should be allocated with a stack of size
+ * STACK_SIZE bytes.
+ * Return value: On success, return the ID of the created Thread.
+ * On failure, return -1.
+*/
+int uthread_spawn(void (*f)(void)){
+    return uthread_spawn_ex(f, nullptr);
+}
+
+
+/*
+ * Description: This function sets the attributes to their default values
+ * (the values uthread_spawn uses).
+ * Return value: On success, return 0. On failure, return -1.
+*/
+int uthread_attr_init(uthread_attr_t *attrs){
+    if (attrs == nullptr){
+        std::cerr << "thread library error: attrs is NULL\n";
+        return FAILURE
+    }
+    attrs->stack_size = STACK_SIZE;
+    return SUCCESS
+}
+
+
+/*
+ * Description: This function creates a new Thread like uthread_spawn, with
+ * the given attributes. attrs->stack_size sets the size of the Thread's
+ * stack - it must be 0 (STACK_SIZE) or at least MIN_STACK_SIZE bytes. The
+ * library adds room for the timer signal frame on top of this size.
+ * attrs may be NULL for the default attributes.
+ * Return value: On success, return the ID of the created Thread.
+ * On failure, return -1.
+*/
+int uthread_spawn_ex(void (*f)(void), const uthread_attr_t *attrs){
+    int stack_size = attrs_stack_size(attrs);
+    if (stack_size < 0){
+        return FAILURE
+    }
+
+    block_signals();
+    int tid = spawn_thread(f, stack_size, nullptr);
+    unblock_signals();
+    return tid;
+}
+
+
+/*
+ * Description: This function creates a new joinable Thread, whose entry
+ * point is the function f with the signature void *f(void *), called with
+ * arg. Its stack is set by attrs as in uthread_spawn_ex. When f returns (or
+ * the Thread calls uthread_exit, or is terminated) the Thread keeps its ID
+ * until another Thread gets the result with uthread_join, unless it was
+ * detached with uthread_detach.
+ * Return value: On success, return the ID of the created Thread.
+ * On failure, return -1.
+*/
+int uthread_spawn_arg(void *(*f)(void *), void *arg, const uthread_attr_t *attrs){
+    int stack_size = attrs_stack_size(attrs);
+    if (stack_size < 0){
+        return FAILURE
+    }
+
+    block_signals();
+    int tid = spawn_thread(nullptr, stack_size, nullptr);
+    if (tid >= 0){
+        // it can't run before we leave the critical section
+        Thread *new_thread = get_thread(tid);
+        new_thread->set_start_routine(f, arg);
+        new_thread->set_detached(false);
+    }
+    unblock_signals();
+    return tid;
+}
+
+
+/*
+ * Description: This function creates a new periodic Thread, which runs
+ * f once every period_usecs micro-seconds (a job), starting now. Each job
+ * should run for at most budget_usecs micro-seconds of CPU time, and finish
+ * within deadline_usecs micro-seconds of its start. Periodic Threads run
+ * before all the other Threads, the one with the earliest deadline first.
+ * A job that runs longer than its budget goes on with the budget of the
+ * next period and a deadline one period later, so it can't delay the other
+ * periodic Threads. The budgets are checked at the end of every quantum, so
+ * the quantum should be well below them.
+ * It is an error to give non-positive times, a budget longer than the
+ * deadline, or a deadline longer than the period. The Thread is not
+ * admitted (an error) if the periodic Threads would need more than one CPU
+ * - the sum of budget_usecs / deadline_usecs of all of them must not exceed
+ * 1, so with EDF they all meet their deadlines while they keep to their
+ * budgets.
+ * Return value: On success, return the ID of the created Thread.
+ * On failure, return -1.
+*/
+int uthread_spawn_periodic(void (*f)(void), int period_usecs, int budget_usecs, int deadline_usecs){
+    if ((period_usecs <= 0) || (budget_usecs <= 0) || (deadline_usecs <= 0) ||
+        (budget_usecs > deadline_usecs) || (deadline_usecs > period_usecs)){
+        std::cerr << "thread library error: invalid period, budget or deadline\n";
+        return FAILURE
+    }
+    auto *reservation = new Reservation((unsigned long)period_usecs * 1000, (unsigned long)budget_usecs * 1000,
+                                        (unsigned long)deadline_usecs * 1000);
+
+    block_signals();
+    if (admitted_density + reservation->get_density() > FULL_DENSITY){
+        unblock_signals();
+        delete reservation;
+        std::cerr << "thread library error: periodic thread not admitted - "
+                     "the periodic threads would need more than one CPU\n";
+        return FAILURE
+    }
+    // the budgets are measured from now on
+    if (!run_time_measured){
+        run_time_measured = true;
+        charge_run_time(nullptr);
+    }
+    int tid = spawn_thread(f, STACK_SIZE, reservation);
+    if (tid < 0){
+        delete reservation;
+    }
+    else {
+        admitted_density += reservation->get_density();
+    }
+    unblock_signals();
+    return tid;
+}
+
+
+/*
+ * Description: This function terminates the Thread with ID tid, see
+ * uthread_terminate - a joinable Thread is kept with result until it is
+ * joined.
+ * Return value: The function returns 0 if the Thread was successfully
+ * terminated and -1 otherwise.
+ */
+int terminate_thread(int tid, void *result){
+    block_signals();
+
+    Thread *to_delete = get_thread(tid);
+    if (to_delete == nullptr){
+        unblock_signals();
+        std::cerr << "thread library error: no Thread with ID tid exists - terminate\n";
+        return FAILURE
+    }
+
+    // main thread
+    if (tid == 0){
+        for (int i = 0; i < threads_table.capacity(); i++){
+            Thread *thread = threads_table.get(i);
+            // the process still runs on the stacks of the running threads
+            if ((thread != nullptr) && ((thread->get_state() != RUNNING) || (thread->get_stack_size() == 0))){
+                delete thread;
+            }
+        }
+        threads_pool.clear();
+        // exit in the critical section - a SIGVTALRM meanwhile must not
+        // switch to the freed threads
+        exit(EXIT_SUCCESS);
+    }
+
+    // thread that runs on another worker - stop it first
+    while ((running_thread_ptr != to_delete) && (to_delete->get_state() == RUNNING)) {
+        to_delete->set_blocked_by_thread(BLOCKED);
+        pthread_kill(workers[to_delete->get_worker()]->get_kernel_thread(), SIGVTALRM);
+        unblock_signals();
+        sched_yield();
+        block_signals();
+        if (get_thread(tid) != to_delete) {
+            // terminated by someone else meanwhile
+            unblock_signals();
+            return SUCCESS
+        }
+    }
+
+    // thread that waits for a mutex (or a periodic thread that waits for its
+    // period, or a sleeping thread)
+    if (to_delete->get_wake_time() != 0) {
+        sleeping_threads.remove(to_delete);
+        next_wakeup.store(sleeping_threads.next_expiry());
+    }
+    if (to_delete->get_queue() != nullptr) {
+        to_delete->get_queue()->remove(to_delete);
+    }
+    if (to_delete->get_reservation() != nullptr) {
+        admitted_density -= to_delete->get_reservation()->get_density();
+    }
+    // thread that waits to join another one
+    if (to_delete->get_joining() != nullptr) {
+        to_delete->get_joining()->set_joiner(nullptr);
+        to_delete->set_joining(nullptr, nullptr);
+    }
+    bool kept = finish_joinable(to_delete, result);
+
+    // running thread
+    if (running_thread_ptr == to_delete) {
+        release_held_mutexes(to_delete);
+        running_dest = 3;
+        // The first thread in the ready queue -> make it the running thread
+        Thread *swap_thread = pop_ready_thread();
+        if (swap_thread == nullptr) {
+            swap_thread = this_worker->get_idle_thread();
+        }
+        swap_thread->set_state(RUNNING);
+        swap_thread->set_worker(this_worker->get_id());
+        running_thread_ptr = swap_thread;
+        if (kept) {
+            to_delete->set_state(ZOMBIE);
+        }
+        else {
+            // Free the prev running thread - its id become available, and it is
+            // released to the pool by the next thread, after we leave its stack
+            free_tid(tid);
+            terminated_thread = to_delete;
+        }
+        // the new thread gets a whole quantum
+        restart_quantum();
+        contact_switch(SIGVTALRM);
+    }
+
+    release_held_mutexes(to_delete);
+    if (kept) {
+        make_unready(to_delete, ZOMBIE);
+        unblock_signals();
+        return SUCCESS
+    }
+    free_tid(tid);
+    // a ready thread is released once its entry is taken from the ready deque
+    release_thread(to_delete);
+    unblock_signals();
+    return SUCCESS
+}
+
+/*
+ * Description: This function terminates the Thread with ID tid and deletes
+ * it from all relevant control structures. All the resources allocated by
+ * the library for this Thread should be released. If no Thread with ID tid
+ * exists it is considered an error. Terminating the main Thread
+ * (tid == 0) will result in the termination of the entire process using
+ * exit(0) [after releasing the assigned library memory].
+ * Return value: The function returns 0 if the Thread was successfully
+ * terminated and -1 otherwise. If a Thread terminates itself or the main
+ * Thread is terminated, the function does not return.
+*/
+int uthread_terminate(int tid){
+    return terminate_thread(tid, nullptr);
+}
+
+
+/*
+ * Description: This function terminates the running Thread, like
+ * uthread_terminate(uthread_get_tid()). If it is joinable, result is what
+ * uthread_join gives the Thread that joins it.
+*/
+void uthread_exit(void *result){
+    terminate_thread(uthread_get_tid(), result);
+}
+
+
+/*
+ * Description: This function waits for the joinable Thread with ID tid to
+ * terminate, stores its result in *result (if result is not NULL) and frees
+ * it. It is an error to join a Thread that doesn't exist, is detached, is
+ * already joined by another Thread, joins the calling Thread, or is the
+ * calling Thread itself.
+ * Return value: On success, return 0. On failure, return -1.
+*/
+int uthread_join(int tid, void **result){
+    block_signals();
+    Thread *to_join = threads_table.get(tid);
+    if (to_join == nullptr){
+        unblock_signals();
+        std::cerr << "thread library error: no Thread with ID tid exists - join\n";
+        return FAILURE
+    }
+    if ((to_join == running_thread_ptr) || (to_join->get_joining() == running_thread_ptr)){
+        unblock_signals();
+        std::cerr << "thread library error: error in uthread_join - thread joins itself\n";
+        return FAILURE
+    }
+    if (to_join->get_detached() || (to_join->get_joiner() != nullptr)){
+        unblock_signals();
+        std::cerr << "thread library error: error in uthread_join - thread is detached or already joined\n";
+        return FAILURE
+    }
+
+    // Terminated already - take its result
+    if (to_join->get_state() == ZOMBIE){
+        if (result != nullptr){
+            *result = to_join->get_result();
+        }
+        free_tid(tid);
+        release_thread(to_join);
+        unblock_signals();
+        return SUCCESS
+    }
+
+    // Wait - the terminating thread hands us its result
+    to_join->set_joiner(running_thread_ptr);
+    running_thread_ptr->set_joining(to_join, result);
+    restart_quantum();
+    // with nothing else to run contact_switch returns at once - sleep until
+    // the thread terminates
+    while (true) {
+        running_dest = 1;
+        contact_switch(120);
+        block_signals();
+        if (running_thread_ptr->get_joining() == nullptr) {
+            break;
+        }
+        idle_wait();
+    }
+    unblock_signals();
+    return SUCCESS
+}
+
+
+/*
+ * Description: This function detaches the joinable Thread with ID tid - it
+ * is freed as soon as it terminates (at once, if it terminated already),
+ * and can't be joined. It is an error to detach a Thread that doesn't
+ * exist, is already detached, or that another Thread waits to join.
+ * Return value: On success, return 0. On failure, return -1.
+*/
+int uthread_detach(int tid){
+    block_signals();
+    Thread *to_detach = threads_table.get(tid);
+    if (to_detach == nullptr){
+        unblock_signals();
+        std::cerr << "thread library error: no Thread with ID tid exists - detach\n";
+        return FAILURE
+    }
+    if (to_detach->get_detached() || (to_detach->get_joiner() != nullptr)){
+        unblock_signals();
+        std::cerr << "thread library error: error in uthread_detach - thread is detached or already joined\n";
+        return FAILURE
+    }
+    if (to_detach->get_state() == ZOMBIE){
+        free_tid(tid);
+        release_thread(to_detach);
+    }
+    else {
+        to_detach->set_detached(true);
+    }
+    unblock_signals();
+    return SUCCESS
+}
+
+/*
+ * Description: This function blocks the Thread with ID tid. The Thread may
+ * be resumed later using uthread_resume. If no Thread with ID tid exists it
+ * is considered as an error. In addition, it is an error to try blocking the
+ * main Thread (tid == 0). If a Thread blocks itself, a scheduling decision
+ * should be made. Blocking a Thread in BLOCKED state has no
+ * effect and is not considered an error.
+ * Return value: On success, return 0. On failure, return -1.
+*/
+int uthread_block(int tid){
+    block_signals();
+    Thread *to_block = get_thread(tid);
+    if (to_block == nullptr){
+        unblock_signals();
+        std::cerr << "thread library error: no Thread with ID tid exists - block\n";
+        return FAILURE
+    }
+    if (tid == 0){
+        unblock_signals();
+        std::cerr << "thread library error: error for block the main thread\n";
+        return FAILURE
+    }
+
+    // blocking the running thread - blocking itself
+    if (running_thread_ptr == to_block){
+        running_dest = 2;
+        restart_quantum();
+        contact_switch(SIGVTALRM);
+        return SUCCESS
+    }
+
+    // blocking a thread that runs on another worker - it stops at its next switch
+    if (to_block->get_state() == RUNNING){
+        to_block->set_blocked_by_thread(BLOCKED);
+        pthread_kill(workers[to_block->get_worker()]->get_kernel_thread(), SIGVTALRM);
+        unblock_signals();
+        return SUCCESS
+    }
+
+    // blocking a thread in the ready queue
+    if (to_block->get_state() == READY) {
+        make_unready(to_block, WAITING);
+    }
+    // a thread in the mutex deque stays there, but will not be ready when it gets the mutex
+    to_block->set_blocked_by_thread(BLOCKED);
+    unblock_signals();
+    return SUCCESS
+}
+
+/*
+ * Description: This function resumes a blocked Thread with ID tid and moves
+ * it to the READY state if it's not synced. Resuming a Thread in a RUNNING or READY state
+ * has no effect and is not considered as an error. If no Thread with
+ * ID tid exists it is considered an error.
+ * Return value: On success, return 0. On failure, return -1.
+*/
+int uthread_resume(int tid){
+    block_signals();
+    Thread *to_ready = get_thread(tid);
+    if (to_ready == nullptr){
+        unblock_signals();
+        std::cerr << "thread library error: error in uthread_terminate function\n";
+        return FAILURE
+    }
+    // From blocked to ready
+    if (to_ready->get_blocked_by_thread()){
+        to_ready->set_blocked_by_thread(UNBLOCKED);
+
+        // a thread that runs on another worker was not stopped yet
+        if (!to_ready->get_blocked_by_mutex() && !to_ready->get_blocked_by_sync() &&
+            !to_ready->get_waiting_release() && (to_ready->get_wake_time() == 0) &&
+            (to_ready->get_joining() == nullptr) && (to_ready->get_state() != RUNNING)){
+            make_ready(to_ready);
+        }
+    }
+    unblock_signals();
+    return SUCCESS
+}
+
+
+/*
+ * Description: This function sets the priority of the Thread with ID tid,
+ * from 0 (the most urgent) to PRIORITY_LEVELS - 1. A new Thread has
+ * DEFAULT_PRIORITY. The READY Thread with the most urgent priority runs
+ * next, and Threads of the same priority run in round robin. A Thread that
+ * becomes READY with a more urgent priority than the running Thread
+ * preempts it. If no Thread with ID tid exists, or the priority is out of
+ * range, it is considered an error.
+ * Return value: On success, return 0. On failure, return -1.
+*/
+int uthread_set_priority(int tid, int priority){
+    if ((priority < 0) || (priority >= PRIORITY_LEVELS)){
+        std::cerr << "thread library error: priority out of range\n";
+        return FAILURE
+    }
+    block_signals();
+    Thread *thread = get_thread(tid);
+    if (thread == nullptr){
+        unblock_signals();
+        std::cerr << "thread library error: no Thread with ID tid exists - set priority\n";
+        return FAILURE
+    }
+    if (thread->get_state() == READY){
+        // move it to the level of its new priority
+        make_unready(thread, WAITING);
+        thread->set_priority(priority);
+        make_ready(thread);
+    }
+    else {
+        thread->set_priority(priority);
+    }
+    // the running thread is preempted if it is no longer the most urgent
+    if ((thread == running_thread_ptr) && POLICY_HOOK(should_yield, *this_worker, thread)){
+        preempt_pending = 1;
+    }
+    unblock_signals();
+    return SUCCESS
+}
+
+
+/*
+ * Description: This function returns the priority of the Thread with ID tid.
+ * If no Thread with ID tid exists it is considered an error.
+ * Return value: On success, return the priority. On failure, return -1.
+*/
+int uthread_get_priority(int tid){
+    block_signals();
+    Thread *thread = get_thread(tid);
+    if (thread == nullptr){
+        unblock_signals();
+        std::cerr << "thread library error: no Thread with ID tid exists - get priority\n";
+        return FAILURE
+    }
+    int priority = thread->get_priority();
+    unblock_signals();
+    return priority;
+}
+
+
+/*
+ * Description: This function sets the quantum of the Thread with ID tid, in
+ * microseconds - 0 means the quantum of the library (see uthread_init_ex).
+ * It takes effect from the next quantum of the Thread. If no Thread with
+ * ID tid exists, or quantum_usecs is negative, it is considered an error.
+ * Return value: On success, return 0. On failure, return -1.
+*/
+int uthread_set_quantum(int tid, int quantum_usecs){
+    if (quantum_usecs < 0){
+        std::cerr << "thread library error: quantum_usecs is negative\n";
+        return FAILURE
+    }
+    block_signals();
+    Thread *thread = get_thread(tid);
+    if (thread == nullptr){
+        unblock_signals();
+        std::cerr << "thread library error: no Thread with ID tid exists - set quantum\n";
+        return FAILURE
+    }
+    thread->set_quantum_usecs(quantum_usecs);
+    unblock_signals();
+    return SUCCESS
+}
+
+
+/*
+ * Description: This function returns the quantum set for the Thread with
+ * ID tid by uthread_set_quantum, 0 if it has none. If no Thread with ID tid
+ * exists it is considered an error.
+ * Return value: On success, return the quantum. On failure, return -1.
+*/
+int uthread_get_quantum(int tid){
+    block_signals();
+    Thread *thread = get_thread(tid);
+    if (thread == nullptr){
+        unblock_signals();
+        std::cerr << "thread library error: no Thread with ID tid exists - get quantum\n";
+        return FAILURE
+    }
+    int quantum_usecs = thread->get_quantum_usecs();
+    unblock_signals();
+    return quantum_usecs;
+}
+
+
+/*
+ * Description: This function moves the running Thread to the end of the
+ * READY threads list and switches to the next READY Thread at once. The
+ * next Thread starts a new quantum, unless the library was initialized with
+ * yield_keeps_quantum - then it runs for the rest of the yielding Thread's
+ * quantum and the timer is not reprogrammed. If no other Thread is READY,
+ * the running Thread continues.
+ * Return value: On success, return 0. On failure, return -1.
+*/
+int uthread_yield(){
+    block_signals();
+    if (!yield_keeps_quantum) {
+        restart_quantum();
+    }
+    running_dest = 1;
+    contact_switch(SIGVTALRM);
+    return SUCCESS
+}
+
+
+/*
+ * Description: This function puts the running thread to sleep until
+ * wake_ns (monotonic ns), see uthread_sleep_until.
+ */
+void sleep_until(unsigned long wake_ns) {
+    block_signals();
+    Thread *thread = running_thread_ptr;
+    if (wake_ns <= monotonic_time()) {
+        unblock_signals();
+        return;
+    }
+    if (this_worker->get_idle_thread() == nullptr) {
+        // all the threads may sleep now - the idle thread waits for the
+        // first of them when the running thread blocks or terminates itself
+        start_main_idle_thread();
+    }
+    thread->set_wake_time(wake_ns);
+    sleeping_threads.insert(thread, monotonic_time());
+    next_wakeup.store(sleeping_threads.next_expiry());
+    restart_quantum();
+    // with nothing else to run contact_switch returns at once - sleep until
+    // the wake time
+    while (true) {
+        running_dest = 1;
+        contact_switch(120);
+        block_signals();
+        if (thread->get_wake_time() == 0) {
+            break;
+        }
+        idle_wait();
+    }
+    unblock_signals();
+}
+
+
+/*
+ * Description: This function puts the running Thread to sleep for usecs
+ * micro-seconds, see uthread_sleep_until. It is an error to give a
+ * negative usecs.
+ * Return value: On success, return 0. On failure, return -1.
+*/
+int uthread_sleep_usec(int usecs){
+    if (usecs < 0){
+        std::cerr << "thread library error: usecs is negative\n";
+        return FAILURE
+    }
+    sleep_until(monotonic_time() + usecs * 1000UL);
+    return SUCCESS
+}
+
+
+/*
+ * Description: This function puts the running Thread to sleep until
+ * wake_time, an absolute time of CLOCK_MONOTONIC. It is an error to give
+ * an invalid time.
+ * Return value: On success, return 0. On failure, return -1.
+*/
+int uthread_sleep_until(const struct timespec *wake_time){
+    if ((wake_time == nullptr) || (wake_time->tv_sec < 0) || (wake_time->tv_nsec < 0) ||
+        (wake_time->tv_nsec >= 1000000000L)){
+        std::cerr << "thread library error: invalid wake time\n";
+        return FAILURE
+    }
+    sleep_until((unsigned long)wake_time->tv_sec * 1000000000UL + (unsigned long)wake_time->tv_nsec);
+    return SUCCESS
+}
+
+
+/*
+ * Description: This function tries to acquire a mutex.
+ * If the mutex is unlocked, it locks it and returns.
+ * If the mutex is already locked by different Thread, the Thread moves to BLOCK state.
+ * When the mutex is unlocked it is handed to the first blocked Thread, which
+ * moves to READY state already holding it.
+ * If the mutex is already locked by this Thread, it is considered an error.
+ * Return value: On success, return 0. On failure, return -1.
+*/
+int uthread_mutex_lock(){
+    return lock_mutex(&default_mutex, "uthread_mutex_lock");
+}
+
+
+/*
+ * Description: This function releases a mutex.
+ * If there are blocked threads waiting for this mutex, the first of them
+ * becomes its owner and moves to READY state.
+ * If the mutex is already unlocked, it is considered an error.
+ * Return value: On success, return 0. On failure, return -1.
+*/
+int uthread_mutex_unlock(){
+    return unlock_mutex(&default_mutex, "uthread_mutex_unlock");
+}
+
+
+/*
+ * Description: This function initializes the mutex, unlocked.
+ * Return value: On success, return 0. On failure, return -1.
+*/
+int uthread_mutex_init(uthread_mutex_t *mutex){
+    if (mutex == nullptr){
+        std::cerr << "thread library error: error in uthread_mutex_init - no mutex\n";
+        return FAILURE
+    }
+    new (get_mutex(mutex)) Mutex();
+    return SUCCESS
+}
+
+
+/*
+ * Description: This function destroys the mutex. It is an error to destroy
+ * a mutex that is locked or that threads wait for.
+ * Return value: On success, return 0. On failure, return -1.
+*/
+int uthread_mutex_destroy(uthread_mutex_t *mutex){
+    if (mutex == nullptr){
+        std::cerr << "thread library error: error in uthread_mutex_destroy - no mutex\n";
+        return FAILURE
+    }
+    block_signals();
+    Mutex *to_destroy = get_mutex(mutex);
+    if (to_destroy->is_locked() || !to_destroy->get_waiters().empty()){
+        unblock_signals();
+        std::cerr << "thread library error: error in uthread_mutex_destroy - the mutex is in use\n";
+        return FAILURE
+    }
+    to_destroy->~Mutex();
+    unblock_signals();
+    return SUCCESS
+}
+
+
+/*
+ * Description: This function acquires the given mutex, like uthread_mutex_lock.
+ * Return value: On success, return 0. On failure, return -1.
+*/
+int uthread_mutex_lock_ex(uthread_mutex_t *mutex){
+    if (mutex == nullptr){
+        std::cerr << "thread library error: error in uthread_mutex_lock_ex - no mutex\n";
+        return FAILURE
+    }
+    return lock_mutex(get_mutex(mutex), "uthread_mutex_lock_ex");
+}
+
+
+/*
+ * Description: This function releases the given mutex, like uthread_mutex_unlock.
+ * Return value: On success, return 0. On failure, return -1.
+*/
+int uthread_mutex_unlock_ex(uthread_mutex_t *mutex){
+    if (mutex == nullptr){
+        std::cerr << "thread library error: error in uthread_mutex_unlock_ex - no mutex\n";
+        return FAILURE
+    }
+    return unlock_mutex(get_mutex(mutex), "uthread_mutex_unlock_ex");
+}
+
+
+/*
+ * Description: This function initializes the condition variable, with no
+ * waiting threads.
+ * Return value: On success, return 0. On failure, return -1.
+*/
+int uthread_cond_init(uthread_cond_t *cond){
+    if (cond == nullptr){
+        std::cerr << "thread library error: error in uthread_cond_init - no condition variable\n";
+        return FAILURE
+    }
+    new (get_cond(cond)) CondVar();
+    return SUCCESS
+}
+
+
+/*
+ * Description: This function destroys the condition variable. It is an
+ * error to destroy a condition variable that threads wait on.
+ * Return value: On success, return 0. On failure, return -1.
+*/
+int uthread_cond_destroy(uthread_cond_t *cond){
+    if (cond == nullptr){
+        std::cerr << "thread library error: error in uthread_cond_destroy - no condition variable\n";
+        return FAILURE
+    }
+    block_signals();
+    CondVar *to_destroy = get_cond(cond);
+    if (!to_destroy->get_waiters().empty()){
+        unblock_signals();
+        std::cerr << "thread library error: error in uthread_cond_destroy - threads wait on it\n";
+        return FAILURE
+    }
+    to_destroy->~CondVar();
+    unblock_signals();
+    return SUCCESS
+}
+
+
+/*
+ * Description: This function releases the mutex (NULL for the mutex of
+ * uthread_mutex_lock), which the running Thread holds, and waits on the
+ * condition variable, in one step. It returns once the Thread was
+ * signalled and holds the mutex again. It is an error to wait without
+ * holding the mutex, or with another mutex than the other waiting Threads.
+ * Return value: On success, return 0. On failure, return -1.
+*/
+int uthread_cond_wait(uthread_cond_t *cond, uthread_mutex_t *mutex){
+    if (cond == nullptr){
+        std::cerr << "thread library error: error in uthread_cond_wait - no condition variable\n";
+        return FAILURE
+    }
+    Mutex *to_release = (mutex == nullptr) ? &default_mutex : get_mutex(mutex);
+    block_signals();
+    CondVar *condition = get_cond(cond);
+    if (to_release->get_owner() != running_thread_ptr->get_tid()){
+        unblock_signals();
+        std::cerr << "thread library error: error in uthread_cond_wait - the mutex is not locked by the thread\n";
+        return FAILURE
+    }
+    if (!condition->get_waiters().empty() && (condition->get_mutex() != to_release)){
+        unblock_signals();
+        std::cerr << "thread library error: error in uthread_cond_wait - the waiting threads use another mutex\n";
+        return FAILURE
+    }
+
+    // Wait on the condition - the signalling thread moves us to the waiters
+    // of the mutex, whose owner hands it to us
+    condition->set_mutex(to_release);
+    release_mutex(to_release);
+    condition->get_waiters().push_back(running_thread_ptr);
+    wait_for_mutex(to_release);
+    unblock_signals();
+    return SUCCESS
+}
+
+
+/*
+ * Description: This function wakes the first Thread that waits on the
+ * condition variable, if any - it moves straight to the waiters of the
+ * mutex (or gets it, if it is unlocked), and returns from uthread_cond_wait
+ * when it holds the mutex.
+ * Return value: On success, return 0. On failure, return -1.
+*/
+int uthread_cond_signal(uthread_cond_t *cond){
+    if (cond == nullptr){
+        std::cerr << "thread library error: error in uthread_cond_signal - no condition variable\n";
+        return FAILURE
+    }
+    block_signals();
+    CondVar *condition = get_cond(cond);
+    if (!condition->get_waiters().empty()){
+        morph_cond_waiter(condition->get_mutex(), condition->get_waiters().pop_front());
+    }
+    unblock_signals();
+    return SUCCESS
+}
+
+
+/*
+ * Description: This function wakes all the Threads that wait on the
+ * condition variable, like uthread_cond_signal - they move to the waiters of
+ * the mutex in their order, and get it one by one.
+ * Return value: On success, return 0. On failure, return -1.
+*/
+int uthread_cond_broadcast(uthread_cond_t *cond){
+    if (cond == nullptr){
+        std::cerr << "thread library error: error in uthread_cond_broadcast - no condition variable\n";
+        return FAILURE
+    }
+    block_signals();
+    CondVar *condition = get_cond(cond);
+    while (!condition->get_waiters().empty()){
+        morph_cond_waiter(condition->get_mutex(), condition->get_waiters().pop_front());
+    }
+    unblock_signals();
+    return SUCCESS
+}
+
+
+/*
+ * Description: This function initializes the semaphore with value units.
+ * It is an error to give a negative value.
+ * Return value: On success, return 0. On failure, return -1.
+*/
+int uthread_sem_init(uthread_sem_t *sem, int value){
+    if (sem == nullptr){
+        std::cerr << "thread library error: error in uthread_sem_init - no semaphore\n";
+        return FAILURE
+    }
+    if (value < 0){
+        std::cerr << "thread library error: error in uthread_sem_init - value is negative\n";
+        return FAILURE
+    }
+    new (get_sem(sem)) Semaphore(value);
+    return SUCCESS
+}
+
+
+/*
+ * Description: This function destroys the semaphore. It is an error to
+ * destroy a semaphore that threads wait for.
+ * Return value: On success, return 0. On failure, return -1.
+*/
+int uthread_sem_destroy(uthread_sem_t *sem){
+    if (sem == nullptr){
+        std::cerr << "thread library error: error in uthread_sem_destroy - no semaphore\n";
+        return FAILURE
+    }
+    block_signals();
+    Semaphore *to_destroy = get_sem(sem);
+    if (!to_destroy->get_waiters().empty()){
+        unblock_signals();
+        std::cerr << "thread library error: error in uthread_sem_destroy - threads wait for it\n";
+        return FAILURE
+    }
+    to_destroy->~Semaphore();
+    unblock_signals();
+    return SUCCESS
+}
+
+
+/*
+ * Description: This function takes a unit of the semaphore - it waits for
+ * one if there is none.
+ * Return value: On success, return 0. On failure, return -1.
+*/
+int uthread_sem_wait(uthread_sem_t *sem){
+    if (sem == nullptr){
+        std::cerr << "thread library error: error in uthread_sem_wait - no semaphore\n";
+        return FAILURE
+    }
+    block_signals();
+    Semaphore *semaphore = get_sem(sem);
+    if (!semaphore->try_acquire()){
+        // Wait in the queue - uthread_sem_post hands the unit to us
+        semaphore->get_waiters().push_back(running_thread_ptr);
+        wait_for_sync();
+    }
+    unblock_signals();
+    return SUCCESS
+}
+
+
+/*
+ * Description: This function takes a unit of the semaphore, if there is
+ * one, without waiting.
+ * Return value: If a unit was taken, return 0. If there was none, return 1.
+ * On failure, return -1.
+*/
+int uthread_sem_trywait(uthread_sem_t *sem){
+    if (sem == nullptr){
+        std::cerr << "thread library error: error in uthread_sem_trywait - no semaphore\n";
+        return FAILURE
+    }
+    block_signals();
+    bool acquired = get_sem(sem)->try_acquire();
+    unblock_signals();
+    return acquired ? 0 : 1;
+}
+
+
+/*
+ * Description: This function gives a unit back to the semaphore - directly
+ * to the first waiting thread, if any.
+ * Return value: On success, return 0. On failure, return -1.
+*/
+int uthread_sem_post(uthread_sem_t *sem){
+    if (sem == nullptr){
+        std::cerr << "thread library error: error in uthread_sem_post - no semaphore\n";
+        return FAILURE
+    }
+    block_signals();
+    Thread *waiter = get_sem(sem)->release();
+    if (waiter != nullptr){
+        wake_sync_waiter(waiter);
+    }
+    unblock_signals();
+    return SUCCESS
+}
+
+
+/*
+ * Description: This function returns the number of units of the semaphore.
+ * Return value: On success, return the number of units. On failure, return -1.
+*/
+int uthread_sem_getvalue(uthread_sem_t *sem){
+    if (sem == nullptr){
+        std::cerr << "thread library error: error in uthread_sem_getvalue - no semaphore\n";
+        return FAILURE
+    }
+    block_signals();
+    int value = get_sem(sem)->get_value();
+    unblock_signals();
+    return value;
+}
+
+
+/*
+ * Description: This function initializes the barrier for count threads. It
+ * is an error to give a count smaller than 1.
+ * Return value: On success, return 0. On failure, return -1.
+*/
+int uthread_barrier_init(uthread_barrier_t *barrier, int count){
+    if (barrier == nullptr){
+        std::cerr << "thread library error: error in uthread_barrier_init - no barrier\n";
+        return FAILURE
+    }
+    if (count < 1){
+        std::cerr << "thread library error: error in uthread_barrier_init - count is smaller than 1\n";
+        return FAILURE
+    }
+    new (get_barrier(barrier)) Barrier(count);
+    return SUCCESS
 }
 
+
 /*
- * Description: This function initializes the Thread library.
- * You may assume that this function is called before any other Thread library
- * function, and that it is called exactly once. The input to the function is
- * the length of a quantum in micro-seconds. It is an error to call this
- * function with non-positive quantum_usecs.
+ * Description: This function destroys the barrier. It is an error to
+ * destroy a barrier that threads wait at.
  * Return value: On success, return 0. On failure, return -1.
 */
-int uthread_init(int quantum_usecs){
+int uthread_barrier_destroy(uthread_barrier_t *barrier){
+    if (barrier == nullptr){
+        std::cerr << "thread library error: error in uthread_barrier_destroy - no barrier\n";
+        return FAILURE
+    }
     block_signals();
-    if (quantum_usecs <= 0){
+    Barrier *to_destroy = get_barrier(barrier);
+    if (!to_destroy->get_waiters().empty()){
         unblock_signals();
-        std::cerr << "thread library error: quantum_usecs is non-positive\n";
+        std::cerr << "thread library error: error in uthread_barrier_destroy - threads wait at it\n";
         return FAILURE
     }
-    auto *main_thread = new Thread(0, nullptr);
-    main_thread->set_state(RUNNING);
-    main_thread->set_blocked_by_thread(UNBLOCKED);
-    main_thread->set_quantum_running_time(1);
-    running_thread_ptr = main_thread;
+    to_destroy->~Barrier();
+    unblock_signals();
+    return SUCCESS
+}
 
-    available_tid = 1;
-    total_quantum++;
 
-    // Install contact_switch as the signal handler for SIGVTALRM.
-    sa.sa_handler = &reset_clock;
-    // After quantum seconds, we will change the running thread
-    if (sigaction(SIGVTALRM, &sa, nullptr) < 0) {
+/*
+ * Description: This function waits at the barrier until count threads
+ * arrived, and then wakes them all.
+ * Return value: On success, return UTHREAD_BARRIER_SERIAL_THREAD for the
+ * last thread to arrive, and 0 for the others. On failure, return -1.
+*/
+int uthread_barrier_wait(uthread_barrier_t *barrier){
+    if (barrier == nullptr){
+        std::cerr << "thread library error: error in uthread_barrier_wait - no barrier\n";
+        return FAILURE
+    }
+    block_signals();
+    Barrier *to_pass = get_barrier(barrier);
+    if (to_pass->completed_by_next()){
+        wake_sync_waiters(to_pass->get_waiters());
         unblock_signals();
-        std::cerr << "system error: sigaction error\n";
-        exit(EXIT_FAILURE);
+        return UTHREAD_BARRIER_SERIAL_THREAD;
     }
-
-    reset_timer(quantum_usecs);
-    sigsetjmp(running_thread_ptr->env[0],1);
-    mutex_pair.first = false;
-    mutex_pair.second = -1;
+    // Wait in the queue - the last thread to arrive wakes us
+    to_pass->get_waiters().push_back(running_thread_ptr);
+    wait_for_sync();
     unblock_signals();
     return SUCCESS
 }
 
 
 /*
- * Description: This function creates a new Thread, whose entry point is the
- * function f with the signature void f(void). The Thread is added to the end
- * of the READY threads list. The uthread_spawn function should fail if it
- * would cause the number of concurrent threads to exceed the limit
- * (MAX_THREAD_NUM). Each Thread should be allocated with a stack of size
- * STACK_SIZE bytes.
- * Return value: On success, return the ID of the created Thread.
- * On failure, return -1.
+ * Description: This function initializes the latch with count. It is an
+ * error to give a negative count.
+ * Return value: On success, return 0. On failure, return -1.
 */
-int uthread_spawn(void (*f)(void)){
-    block_signals();
-    if ((available_tid + 1 > MAX_THREAD_NUM) && min_available_tids.empty()){
-        unblock_signals();
-        std::cerr << "thread library error: error in uthread_spawn function\n";
+int uthread_latch_init(uthread_latch_t *latch, int count){
+    if (latch == nullptr){
+        std::cerr << "thread library error: error in uthread_latch_init - no latch\n";
         return FAILURE
     }
-
-    // when there is id that is in the available id-s, we want to create new thread with the minimal id
-    if (!min_available_tids.empty()) {
-        int min_elem_set = *min_available_tids.begin();
-        auto *new_thread = new Thread(min_elem_set, f);
-        ready_threads_map.insert({min_elem_set, new_thread});
-        new_thread->set_state(READY);
-        new_thread->set_blocked_by_thread(UNBLOCKED);
-        ordered_deque_threads.push_back(new_thread);
-        min_available_tids.erase(min_elem_set); // delete from the available set of threads
-        unblock_signals();
-        return min_elem_set;
+    if (count < 0){
+        std::cerr << "thread library error: error in uthread_latch_init - count is negative\n";
+        return FAILURE
     }
-    auto *new_thread = new Thread(available_tid, f);
-    ready_threads_map.insert({available_tid, new_thread});
-    new_thread->set_state(READY);
-    new_thread->set_blocked_by_thread(UNBLOCKED);
-    ordered_deque_threads.push_back(new_thread);
-    available_tid++;
-    unblock_signals();
-    return available_tid - 1;
+    new (get_latch(latch)) Latch(count);
+    return SUCCESS
 }
 
 
 /*
- * Description: This function terminates the Thread with ID tid and deletes
- * it from all relevant control structures. All the resources allocated by
- * the library for this Thread should be released. If no Thread with ID tid
- * exists it is considered an error. Terminating the main Thread
- * (tid == 0) will result in the termination of the entire process using
- * exit(0) [after releasing the assigned library memory].
- * Return value: The function returns 0 if the Thread was successfully
- * terminated and -1 otherwise. If a Thread terminates itself or the main
- * Thread is terminated, the function does not return.
+ * Description: This function destroys the latch. It is an error to destroy
+ * a latch that threads wait for.
+ * Return value: On success, return 0. On failure, return -1.
 */
-int uthread_terminate(int tid){
+int uthread_latch_destroy(uthread_latch_t *latch){
+    if (latch == nullptr){
+        std::cerr << "thread library error: error in uthread_latch_destroy - no latch\n";
+        return FAILURE
+    }
     block_signals();
-
-    if ((min_available_tids.find(tid) != min_available_tids.end()) || (available_tid <= tid) || (tid < 0)){
+    Latch *to_destroy = get_latch(latch);
+    if (!to_destroy->get_waiters().empty()){
         unblock_signals();
-        std::cerr << "thread library error: no Thread with ID tid exists - terminate\n";
+        std::cerr << "thread library error: error in uthread_latch_destroy - threads wait for it\n";
         return FAILURE
     }
+    to_destroy->~Latch();
+    unblock_signals();
+    return SUCCESS
+}
 
-    // main thread
-    if (tid == 0){
-        bool running_in_ready = false;
-        while (!blocked_threads.empty()){
-            auto it = blocked_threads.begin();
-            Thread* to_delete = it->second;
-            erase_from_map(to_delete->get_tid(), BLOCKED_MAP);
-            if (!to_delete->get_blocked_by_mutex())
-            {
-                delete to_delete;
-            }
-        }
-        blocked_threads.clear();
 
-        while (!ready_threads_map.empty()){
-            auto it = ready_threads_map.begin();
-            Thread* to_delete = it->second;
-            erase_from_map(it->second->get_tid(), READY_MAP);
-            if (to_delete->get_tid() == running_thread_ptr->get_tid())
-            {
-                running_in_ready = true;
-            }
-            delete to_delete;
-        }
-        ready_threads_map.clear();
-        ordered_deque_threads.clear();
-        min_available_tids.clear();
+/*
+ * Description: This function decrements the count of the latch, and wakes
+ * the waiting threads when it reaches zero. It is an error to count down a
+ * latch whose count is zero.
+ * Return value: On success, return 0. On failure, return -1.
+*/
+int uthread_latch_count_down(uthread_latch_t *latch){
+    if (latch == nullptr){
+        std::cerr << "thread library error: error in uthread_latch_count_down - no latch\n";
+        return FAILURE
+    }
+    return add_to_latch(get_latch(latch), -1, "uthread_latch_count_down");
+}
 
-        for (Thread* thread: mutex_deque_threads){
-            delete thread;
-        }
-        mutex_deque_threads.clear();
 
-        if (!running_in_ready)
-        {
-            delete running_thread_ptr;
-        }
-        unblock_signals();
-        exit(EXIT_SUCCESS);
+/*
+ * Description: This function waits until the count of the latch is zero.
+ * Return value: On success, return 0. On failure, return -1.
+*/
+int uthread_latch_wait(uthread_latch_t *latch){
+    if (latch == nullptr){
+        std::cerr << "thread library error: error in uthread_latch_wait - no latch\n";
+        return FAILURE
     }
+    return wait_latch(get_latch(latch));
+}
 
-    // running thread
-    if (running_thread_ptr->get_tid() == tid) {
-        if (mutex_pair.second == running_thread_ptr->get_tid()){
-            uthread_mutex_unlock();
-        }
-        running_dest = 3;
-        // The running thread that we want to terminate
-        Thread *wanted_thread_to_delete = running_thread_ptr;
-        // The first thread in the ready deque -> make it the running thread
-        Thread *swap_thread = ordered_deque_threads.front();
-        ordered_deque_threads.pop_front();
-        erase_from_map(swap_thread->get_tid(), READY_MAP);
-        // The terminated running thread -> take its id -> become available
-        min_available_tids.insert(wanted_thread_to_delete->get_tid());
-        // Making the first thread in the ready deque, the running thread
-        swap_thread->set_state(RUNNING);
-        running_thread_ptr = swap_thread;
-        // Free the prev running thread
-        min_available_tids.insert(wanted_thread_to_delete->get_tid());
-        delete wanted_thread_to_delete;
-        // reset the timer for the new thread
-        if (setitimer (ITIMER_VIRTUAL, &timer, nullptr)) {
-            unblock_signals();
-            std::cerr << "thread library error: setitimer error\n";
-        }
-        contact_switch(SIGVTALRM);
-    }
 
-    // ready thread
-    if (ready_threads_map.find(tid) != ready_threads_map.end()) {
-        Thread *to_delete = ready_threads_map[tid];
-        ordered_deque_threads.erase(std::remove(ordered_deque_threads.begin(), ordered_deque_threads.end(),
-                                                ready_threads_map[tid]), ordered_deque_threads.end());
-        erase_from_map(to_delete->get_tid(), READY_MAP);// delete the thread from the ready map
-        min_available_tids.insert(to_delete->get_tid());
-        if (to_delete->get_tid() == mutex_pair.second){
-            mutex_pair.first = false;
-            mutex_pair.second = -1;
-            if (!mutex_deque_threads.empty()) {
-                Thread *blocked_to_ready = mutex_deque_threads.front();
-                mutex_deque_threads.pop_front();
-                blocked_to_ready->set_blocked_by_mutex(false);
-
-                if (!blocked_to_ready->get_blocked_by_thread()) {
-                    ready_threads_map.insert({blocked_to_ready->get_tid(), blocked_to_ready});
-                    blocked_to_ready->set_state(READY);
-                    ordered_deque_threads.push_back(blocked_to_ready);
-                }
-            }
-        }
-        delete to_delete;
-    }
-
-    // blocked thread
-    if (blocked_threads.find(tid) != blocked_threads.end()){
-        Thread *to_delete = blocked_threads[tid];
-        if (to_delete->get_tid() == mutex_pair.second){
-            mutex_pair.first = false;
-            mutex_pair.second = -1;
-            if (!mutex_deque_threads.empty()) {
-                Thread *blocked_to_ready = mutex_deque_threads.front();
-                mutex_deque_threads.pop_front();
-                blocked_to_ready->set_blocked_by_mutex(false);
-
-                if (!blocked_to_ready->get_blocked_by_thread()) {
-                    ready_threads_map.insert({blocked_to_ready->get_tid(), blocked_to_ready});
-                    blocked_to_ready->set_state(READY);
-                    ordered_deque_threads.push_back(blocked_to_ready);
-                }
-            }
-        }
-        min_available_tids.insert(blocked_threads[tid]->get_tid());
-        erase_from_map(blocked_threads[tid]->get_tid(), BLOCKED_MAP);// delete the thread from the blocked map
-        delete to_delete;
+/*
+ * Description: This function initializes the wait group, with a count of 0.
+ * Return value: On success, return 0. On failure, return -1.
+*/
+int uthread_waitgroup_init(uthread_waitgroup_t *group){
+    if (group == nullptr){
+        std::cerr << "thread library error: error in uthread_waitgroup_init - no wait group\n";
+        return FAILURE
     }
-    unblock_signals();
+    new (get_waitgroup(group)) Latch(0);
     return SUCCESS
 }
 
+
 /*
- * Description: This function blocks the Thread with ID tid. The Thread may
- * be resumed later using uthread_resume. If no Thread with ID tid exists it
- * is considered as an error. In addition, it is an error to try blocking the
- * main Thread (tid == 0). If a Thread blocks itself, a scheduling decision
- * should be made. Blocking a Thread in BLOCKED state has no
- * effect and is not considered an error.
+ * Description: This function destroys the wait group. It is an error to
+ * destroy a wait group that threads wait for.
  * Return value: On success, return 0. On failure, return -1.
 */
-int uthread_block(int tid){
+int uthread_waitgroup_destroy(uthread_waitgroup_t *group){
+    if (group == nullptr){
+        std::cerr << "thread library error: error in uthread_waitgroup_destroy - no wait group\n";
+        return FAILURE
+    }
     block_signals();
-    if ((min_available_tids.find(tid) != min_available_tids.end()) || (available_tid <= tid) || (tid < 0)){
+    Latch *to_destroy = get_waitgroup(group);
+    if (!to_destroy->get_waiters().empty()){
         unblock_signals();
-        std::cerr << "thread library error: no Thread with ID tid exists - block\n";
+        std::cerr << "thread library error: error in uthread_waitgroup_destroy - threads wait for it\n";
         return FAILURE
     }
-    if (tid == 0){
-        unblock_signals();
-        std::cerr << "thread library error: error for block the main thread\n";
+    to_destroy->~Latch();
+    unblock_signals();
+    return SUCCESS
+}
+
+
+/*
+ * Description: This function adds delta (may be negative) to the count of
+ * the wait group, and wakes the waiting threads when it reaches zero. It is
+ * an error to make the count negative.
+ * Return value: On success, return 0. On failure, return -1.
+*/
+int uthread_waitgroup_add(uthread_waitgroup_t *group, int delta){
+    if (group == nullptr){
+        std::cerr << "thread library error: error in uthread_waitgroup_add - no wait group\n";
         return FAILURE
     }
+    return add_to_latch(get_waitgroup(group), delta, "uthread_waitgroup_add");
+}
 
-    // blocking the running thread - blocking itself
-    if (running_thread_ptr->get_tid() == tid){
-        running_dest = 2;
 
-        if (setitimer (ITIMER_VIRTUAL, &timer, nullptr)) {
-            unblock_signals();
-            std::cerr << "thread library error: setitimer error\n";
-        }
-        contact_switch(SIGVTALRM);
+/*
+ * Description: This function decrements the count of the wait group, like
+ * uthread_waitgroup_add(group, -1).
+ * Return value: On success, return 0. On failure, return -1.
+*/
+int uthread_waitgroup_done(uthread_waitgroup_t *group){
+    if (group == nullptr){
+        std::cerr << "thread library error: error in uthread_waitgroup_done - no wait group\n";
+        return FAILURE
     }
+    return add_to_latch(get_waitgroup(group), -1, "uthread_waitgroup_done");
+}
 
-    // blocking a thread in the ready thread
-    if (ready_threads_map.find(tid) != ready_threads_map.end()) {
-        Thread *to_block_from_ready = ready_threads_map[tid];
-        ordered_deque_threads.erase(std::remove(ordered_deque_threads.begin(), ordered_deque_threads.end(),
-                                                ready_threads_map[tid]), ordered_deque_threads.end());
-        erase_from_map(to_block_from_ready->get_tid(), READY_MAP); // delete the thread from the ready map
-        // blocked the thread from the ready map
-        to_block_from_ready->set_blocked_by_thread(BLOCKED);
-        blocked_threads.insert({to_block_from_ready->get_tid(), to_block_from_ready});
+
+/*
+ * Description: This function waits until the count of the wait group is zero.
+ * Return value: On success, return 0. On failure, return -1.
+*/
+int uthread_waitgroup_wait(uthread_waitgroup_t *group){
+    if (group == nullptr){
+        std::cerr << "thread library error: error in uthread_waitgroup_wait - no wait group\n";
+        return FAILURE
     }
-    else {
-        // blocking a thread that in the mutex deque
-        for (auto in_deque_mutex : mutex_deque_threads){
-            if (in_deque_mutex->get_tid() == tid){
-                in_deque_mutex->set_blocked_by_thread(BLOCKED);
-                blocked_threads.insert({in_deque_mutex->get_tid(), in_deque_mutex});
-            }
-        }
+    return wait_latch(get_waitgroup(group));
+}
+
+
+/*
+ * Description: This function initializes the reader-writer lock. If
+ * prefer_writers is not 0, new readers wait while a writer waits.
+ * Return value: On success, return 0. On failure, return -1.
+*/
+int uthread_rwlock_init(uthread_rwlock_t *rwlock, int prefer_writers){
+    if (rwlock == nullptr){
+        std::cerr << "thread library error: error in uthread_rwlock_init - no lock\n";
+        return FAILURE
     }
-    unblock_signals();
+    new (get_rwlock(rwlock)) RWLock(prefer_writers != 0);
     return SUCCESS
 }
 
+
 /*
- * Description: This function resumes a blocked Thread with ID tid and moves
- * it to the READY state if it's not synced. Resuming a Thread in a RUNNING or READY state
- * has no effect and is not considered as an error. If no Thread with
- * ID tid exists it is considered an error.
+ * Description: This function destroys the reader-writer lock. It is an
+ * error to destroy a lock that is held, or that threads wait for.
  * Return value: On success, return 0. On failure, return -1.
 */
-int uthread_resume(int tid){
+int uthread_rwlock_destroy(uthread_rwlock_t *rwlock){
+    if (rwlock == nullptr){
+        std::cerr << "thread library error: error in uthread_rwlock_destroy - no lock\n";
+        return FAILURE
+    }
     block_signals();
-    if ((min_available_tids.find(tid) != min_available_tids.end()) || (available_tid <= tid) || (tid < 0)){
+    RWLock *to_destroy = get_rwlock(rwlock);
+    if (to_destroy->is_locked()){
         unblock_signals();
-        std::cerr << "thread library error: error in uthread_terminate function\n";
+        std::cerr << "thread library error: error in uthread_rwlock_destroy - the lock is held\n";
         return FAILURE
     }
-    // From blocked to ready
-    if (blocked_threads.find(tid) != blocked_threads.end()){
-        Thread* to_ready = blocked_threads[tid];
-        erase_from_map(tid, BLOCKED_MAP);
-        to_ready->set_blocked_by_thread(UNBLOCKED);
-
-        if (!to_ready->get_blocked_by_mutex()){
-            ready_threads_map.insert({tid, to_ready});
-            to_ready->set_state(READY);
-            ordered_deque_threads.push_back(to_ready);
-        }
+    if (to_destroy->has_waiters()){
+        unblock_signals();
+        std::cerr << "thread library error: error in uthread_rwlock_destroy - threads wait for the lock\n";
+        return FAILURE
     }
+    to_destroy->~RWLock();
     unblock_signals();
     return SUCCESS
 }
 
 
 /*
- * Description: This function tries to acquire a mutex.
- * If the mutex is unlocked, it locks it and returns.
- * If the mutex is already locked by different Thread, the Thread moves to BLOCK state.
- * In the future when this Thread will be back to RUNNING state,
- * it will try again to acquire the mutex.
- * If the mutex is already locked by this Thread, it is considered an error.
+ * Description: This function takes the reader-writer lock for reading - it
+ * waits while a writer holds it (or, with writer preference, waits for it).
+ * It is an error to take it while holding it for writing, or while holding
+ * MAX_HELD_RWLOCKS other locks - a waiting thread then has room for the
+ * lock it is handed.
  * Return value: On success, return 0. On failure, return -1.
 */
-int uthread_mutex_lock(){
+int uthread_rwlock_rdlock(uthread_rwlock_t *rwlock){
+    if (rwlock == nullptr){
+        std::cerr << "thread library error: error in uthread_rwlock_rdlock - no lock\n";
+        return FAILURE
+    }
     block_signals();
-
-    // The mutex is available
-    if (!mutex_pair.first){
-        mutex_pair.first = true;
-        mutex_pair.second = running_thread_ptr->get_tid();
+    RWLock *lock = get_rwlock(rwlock);
+    if (lock->get_writer() == running_thread_ptr->get_tid()){
         unblock_signals();
-        return SUCCESS
+        std::cerr << "thread library error: error in uthread_rwlock_rdlock - the thread holds it for writing\n";
+        return FAILURE
     }
-
-    if (mutex_pair.first){
-        // If the mutex is already locked by this Thread, it is considered an error
-        if (mutex_pair.second == running_thread_ptr->get_tid())
-        {
-            std::cerr << "thread library error: error in uthread_mutex_lock - "
-                         "thread tries to lock itself\n";
-            unblock_signals();
-            return -1;
-        }
-        else
-        {
-            while (mutex_pair.first) {
-                mutex_deque_threads.push_back(running_thread_ptr);
-                running_thread_ptr->set_blocked_by_mutex(true);
-                if (setitimer (ITIMER_VIRTUAL, &timer, nullptr)) {
-                    unblock_signals();
-                    std::cerr << "thread library error: setitimer error\n";
-                }
-                running_dest = 1;
-                contact_switch(120);
-            }
-            mutex_pair.first = true;
-            mutex_pair.second = running_thread_ptr->get_tid();
-            running_thread_ptr->set_blocked_by_mutex(false);
-            unblock_signals();
-            return SUCCESS
-        }
+    if (!running_thread_ptr->can_hold_rwlock(lock)){
+        unblock_signals();
+        std::cerr << "thread library error: error in uthread_rwlock_rdlock - the thread holds MAX_HELD_RWLOCKS locks\n";
+        return FAILURE
+    }
+    if (!lock->try_read_lock(running_thread_ptr)){
+        // Wait in the queue - uthread_rwlock_unlock hands the lock to us
+        lock->get_waiting_readers().push_back(running_thread_ptr);
+        wait_for_sync();
     }
     unblock_signals();
     return SUCCESS
@@ -604,50 +2947,66 @@ int uthread_mutex_lock(){
 
 
 /*
- * Description: This function releases a mutex.
- * If there are blocked threads waiting for this mutex,
- * one of them (no matter which one) moves to READY state.
- * If the mutex is already unlocked, it is considered an error.
+ * Description: This function takes the reader-writer lock for writing - it
+ * waits while any thread holds it. It is an error to take it while holding
+ * it (for writing, or for reading - it would wait for itself), or while
+ * holding MAX_HELD_RWLOCKS other locks.
  * Return value: On success, return 0. On failure, return -1.
 */
-int uthread_mutex_unlock(){
+int uthread_rwlock_wrlock(uthread_rwlock_t *rwlock){
+    if (rwlock == nullptr){
+        std::cerr << "thread library error: error in uthread_rwlock_wrlock - no lock\n";
+        return FAILURE
+    }
     block_signals();
-
-    // If the mutex is already unlocked, it is considered an error.
-    if (!mutex_pair.first){
-        std::cerr << "thread library error: error in uthread_mutex_unlock - "
-                     "unlocking thread that is already unlocked\n";
+    RWLock *lock = get_rwlock(rwlock);
+    if (lock->get_writer() == running_thread_ptr->get_tid()){
+        unblock_signals();
+        std::cerr << "thread library error: error in uthread_rwlock_wrlock - the thread holds it for writing\n";
+        return FAILURE
+    }
+    if (running_thread_ptr->holds_rwlock(lock)){
+        unblock_signals();
+        std::cerr << "thread library error: error in uthread_rwlock_wrlock - the thread holds it for reading\n";
+        return FAILURE
+    }
+    if (!running_thread_ptr->can_hold_rwlock(lock)){
         unblock_signals();
+        std::cerr << "thread library error: error in uthread_rwlock_wrlock - the thread holds MAX_HELD_RWLOCKS locks\n";
         return FAILURE
     }
+    if (!lock->try_write_lock(running_thread_ptr)){
+        // Wait in the queue - uthread_rwlock_unlock hands the lock to us
+        lock->get_waiting_writers().push_back(running_thread_ptr);
+        wait_for_sync();
+    }
+    unblock_signals();
+    return SUCCESS
+}
 
-    if (mutex_pair.first) {
 
-        if (running_thread_ptr->get_tid() != mutex_pair.second)
-        {
-            std::cerr << "thread library error: error in uthread_mutex_unlock - "
-                         "the mutex has been unlocked by another thread\n";
-            unblock_signals();
-            return FAILURE
-
-        }
-        else
-        {
-            mutex_pair.first = false;
-            mutex_pair.second = -1;
-            if (!mutex_deque_threads.empty()) {
-                Thread *blocked_to_ready = mutex_deque_threads.front();
-                mutex_deque_threads.pop_front();
-                blocked_to_ready->set_blocked_by_mutex(false);
-
-                if (!blocked_to_ready->get_blocked_by_thread()) {
-                    ready_threads_map.insert({blocked_to_ready->get_tid(), blocked_to_ready});
-                    blocked_to_ready->set_state(READY);
-                    ordered_deque_threads.push_back(blocked_to_ready);
-                }
-            }
-        }
+/*
+ * Description: This function releases the reader-writer lock, which the
+ * running thread holds for writing or for reading. If that frees it, it is
+ * handed directly to the waiting threads - all the readers together, or
+ * the first writer. It is an error to release a lock the running thread
+ * doesn't hold.
+ * Return value: On success, return 0. On failure, return -1.
+*/
+int uthread_rwlock_unlock(uthread_rwlock_t *rwlock){
+    if (rwlock == nullptr){
+        std::cerr << "thread library error: error in uthread_rwlock_unlock - no lock\n";
+        return FAILURE
     }
+    block_signals();
+    RWLock *lock = get_rwlock(rwlock);
+    ThreadQueue woken;
+    if (!lock->release(running_thread_ptr, woken)){
+        unblock_signals();
+        std::cerr << "thread library error: error in uthread_rwlock_unlock - the thread doesn't hold it\n";
+        return FAILURE
+    }
+    wake_sync_waiters(woken);
     unblock_signals();
     return SUCCESS
 }
@@ -688,25 +3047,94 @@ int uthread_get_total_quantums(){
 int uthread_get_quantums(int tid){
     block_signals();
 
-    if ((min_available_tids.find(tid) != min_available_tids.end()) || (available_tid <= tid) || (tid < 0)){
+    Thread *thread = get_thread(tid);
+    if (thread == nullptr){
         unblock_signals();
         std::cerr << "thread library error: error in uthread_terminate function\n";
         return FAILURE
     }
-    // running thread
-    if (running_thread_ptr->get_tid() == tid){
+    int quantums = thread->get_quantum_running_time();
+    unblock_signals();
+    return quantums;
+}
+
+
+/*
+ * Description: This function returns the CPU time the Thread with ID tid
+ * ran, in nanoseconds (including the current quantum if it is RUNNING).
+ * The run time is measured only with UTHREAD_POLICY_FAIR (see uthread_init_ex),
+ * or since the first periodic Thread was spawned. If no Thread with ID tid
+ * exists it is considered an error.
+ * Return value: On success, return the run time of the Thread with ID tid.
+ * 			     On failure, return -1.
+*/
+long long uthread_get_run_time(int tid){
+    block_signals();
+
+    Thread *thread = get_thread(tid);
+    if (thread == nullptr){
         unblock_signals();
-        return running_thread_ptr->get_quantum_running_time();
+        std::cerr << "thread library error: no Thread with ID tid exists - get run time\n";
+        return FAILURE
     }
-    // ready thread
-    else if (ready_threads_map.find(tid) != ready_threads_map.end()) {
-        unblock_signals();
-        return ready_threads_map[tid]->get_quantum_running_time();
+    if (thread == running_thread_ptr) {
+        POLICY_HOOK(on_tick, thread, charge_run_time(thread));
     }
-    // blocked thread ==> blocked_threads.find(tid) != blocked_threads.end()
-    else {
+    long long run_time = (long long)thread->get_run_time();
+    unblock_signals();
+    return run_time;
+}
+
+
+/*
+ * Description: This function fills stats with the statistics of the
+ * periodic Thread with ID tid (see uthread_spawn_periodic). It is an error
+ * if no Thread with ID tid exists, or if it is not periodic.
+ * Return value: On success, return 0. On failure, return -1.
+*/
+int uthread_get_periodic_stats(int tid, uthread_periodic_stats_t *stats){
+    if (stats == nullptr){
+        std::cerr << "thread library error: stats is NULL\n";
+        return FAILURE
+    }
+    block_signals();
+    Thread *thread = get_thread(tid);
+    if ((thread == nullptr) || (thread->get_reservation() == nullptr)){
         unblock_signals();
-        return blocked_threads[tid]->get_quantum_running_time();
+        std::cerr << "thread library error: no periodic Thread with ID tid exists - get periodic stats\n";
+        return FAILURE
     }
+    Reservation *reservation = thread->get_reservation();
+    stats->jobs = reservation->get_jobs();
+    stats->missed_deadlines = reservation->get_missed_deadlines();
+    stats->overruns = reservation->get_overruns();
+    stats->max_job_usecs = (long long)(reservation->get_max_job_time() / 1000);
+    stats->max_response_usecs = (long long)(reservation->get_max_response_time() / 1000);
+    unblock_signals();
+    return SUCCESS
 }
 
+
+/*
+ * Description: This function fills stats with the statistics of the
+ * scheduler since uthread_init - the switch rate is switches divided by
+ * elapsed_usecs. The latency (from becoming READY to running) is measured
+ * only if the library was initialized with sched_stats.
+ * Return value: On success, return 0. On failure, return -1.
+*/
+int uthread_get_sched_stats(uthread_sched_stats_t *stats){
+    if (stats == nullptr){
+        std::cerr << "thread library error: stats is NULL\n";
+        return FAILURE
+    }
+    block_signals();
+    stats->elapsed_usecs = (long long)((monotonic_time() - init_time) / 1000);
+    stats->switches = switch_count;
+    stats->preemptions = preempt_count;
+    stats->quantum_usecs = (int)(armed_quantum_ns / 1000);
+    stats->latency_samples = latency_samples;
+    stats->avg_latency_usecs = (latency_samples == 0) ? 0 : (long long)(latency_total / latency_samples / 1000);
+    stats->max_latency_usecs = (long long)(latency_max / 1000);
+    unblock_signals();
+    return SUCCESS
+}
@@ -1,6 +1,8 @@
 #ifndef _UTHREADS_H
 #define _UTHREADS_H
 
+#include <time.h>
+
 
 
 
@@ -9,8 +11,102 @@
  * Author: OS, os@cs.huji.ac.il
  */
 
-#define MAX_THREAD_NUM 100 /* maximal number of threads */
+#ifndef MAX_THREAD_NUM
+#define MAX_THREAD_NUM 100 /* default maximal number of threads, see the max_threads option of uthread_init_ex */
+#endif
 #define STACK_SIZE 4096 /* stack size per Thread (in bytes) */
+#define MIN_STACK_SIZE 2048 /* smallest stack size uthread_spawn_ex accepts (in bytes) */
+#ifndef PRIORITY_LEVELS
+#define PRIORITY_LEVELS 32 /* number of priority levels (up to 64), 0 is the most urgent */
+#endif
+#define DEFAULT_PRIORITY (PRIORITY_LEVELS / 2) /* priority of a new Thread */
+#ifndef THREAD_POOL_SIZE
+#define THREAD_POOL_SIZE 32 /* default number of terminated threads kept for reuse */
+
+#define MAX_HELD_RWLOCKS 16 /* reader-writer locks a Thread may hold at once (see uthread_rwlock_rdlock) */
+#endif
+#define UTHREAD_POLICY_PRIORITY 0 /* strict priorities, round robin within each (the default) */
+#define UTHREAD_POLICY_ROUND_ROBIN 1 /* round robin, the priorities are ignored */
+#define UTHREAD_POLICY_FAIR 2 /* fair scheduling by virtual runtime */
+#define UTHREAD_CLOCK_VIRTUAL 0 /* CPU time, by setitimer(ITIMER_VIRTUAL) (the default) */
+#define UTHREAD_CLOCK_CPU 1 /* CPU time, by a POSIX timer (timer_create) */
+#define UTHREAD_CLOCK_MONOTONIC 2 /* wall-clock time, by a POSIX timer with absolute deadlines */
+#define UTHREAD_BARRIER_SERIAL_THREAD 1 /* what uthread_barrier_wait returns to the last Thread to arrive */
+
+/* Attributes of a new Thread, see uthread_spawn_ex */
+typedef struct {
+    int stack_size; /* stack size in bytes, 0 means STACK_SIZE */
+} uthread_attr_t;
+
+/* Options of the library, see uthread_init_ex */
+typedef struct {
+    int pool_size; /* max number of terminated threads (with their stacks) kept for reuse */
+    int pool_prewarm; /* number of threads with STACK_SIZE stacks created in advance */
+    int yield_keeps_quantum; /* non-zero: uthread_yield gives the rest of the quantum to the next thread */
+    int workers; /* number of kernel threads that run the threads in parallel (M:N mode if > 1) */
+    int policy; /* scheduling policy of the ready Threads, one of UTHREAD_POLICY_* */
+    int adaptive_quantum; /* non-zero: the quantum shrinks when many Threads are READY and grows when few are */
+    int sched_stats; /* non-zero: measure the scheduling latency, see uthread_get_sched_stats */
+    int tickless; /* non-zero: stop the timer while the running Thread is the only runnable one */
+    int clock; /* the clock the quanta are measured in, one of UTHREAD_CLOCK_* */
+    int quantum_nsecs; /* non-zero: the quantum in nanoseconds, instead of quantum_usecs */
+    int max_threads; /* maximal number of concurrent threads, including the main Thread (up to millions) */
+} uthread_options_t;
+
+/* Statistics of a periodic Thread, see uthread_get_periodic_stats */
+typedef struct {
+    int jobs; /* jobs completed */
+    int missed_deadlines; /* jobs completed after their deadline */
+    int overruns; /* times a job used up its budget */
+    long long max_job_usecs; /* CPU time of the longest job */
+    long long max_response_usecs; /* longest time from the start of a job's period to its completion */
+} uthread_periodic_stats_t;
+
+/* Statistics of the scheduler, see uthread_get_sched_stats */
+typedef struct {
+    long long elapsed_usecs; /* time since uthread_init */
+    long long switches; /* switches from one Thread to another */
+    long long preemptions; /* switches away from a Thread that was still READY */
+    int quantum_usecs; /* the quantum the calling Thread runs with, 0 while the timer is stopped (tickless) */
+    long long latency_samples; /* times a READY Thread started running (with sched_stats) */
+    long long avg_latency_usecs; /* average time from becoming READY to running */
+    long long max_latency_usecs; /* longest time from becoming READY to running */
+} uthread_sched_stats_t;
+
+/* A mutex object, see uthread_mutex_init. Its content is private to the library */
+typedef struct {
+    void *storage[8];
+} uthread_mutex_t;
+
+/* A condition variable object, see uthread_cond_init. Its content is private to the library */
+typedef struct {
+    void *storage[8];
+} uthread_cond_t;
+
+/* A counting semaphore object, see uthread_sem_init. Its content is private to the library */
+typedef struct {
+    void *storage[8];
+} uthread_sem_t;
+
+/* A barrier object, see uthread_barrier_init. Its content is private to the library */
+typedef struct {
+    void *storage[8];
+} uthread_barrier_t;
+
+/* A latch object, see uthread_latch_init. Its content is private to the library */
+typedef struct {
+    void *storage[8];
+} uthread_latch_t;
+
+/* A wait group object, see uthread_waitgroup_init. Its content is private to the library */
+typedef struct {
+    void *storage[8];
+} uthread_waitgroup_t;
+
+/* A reader-writer lock object, see uthread_rwlock_init. Its content is private to the library */
+typedef struct {
+    void *storage[8];
+} uthread_rwlock_t;
 
 /* External interface */
 
@@ -26,19 +122,149 @@
 */
 int uthread_init(int quantum_usecs);
 
+
+/*
+ * Description: This function sets the options to their default values
+ * (the values uthread_init uses).
+ * Return value: On success, return 0. On failure, return -1.
+*/
+int uthread_options_init(uthread_options_t *options);
+
+
+/*
+ * Description: This function initializes the Thread library like
+ * uthread_init, with the given options. options may be NULL for the
+ * default options. It is an error to give a negative pool size, to
+ * prewarm more threads than the pool size, less than one worker, a
+ * policy the library was not built with, an unknown clock, a negative
+ * quantum_nsecs (quantum_usecs is checked only if quantum_nsecs is 0) or
+ * max_threads smaller than 1.
+ * max_threads is MAX_THREAD_NUM by default. The thread table grows with the
+ * number of Threads, so a large limit costs nothing until it is used - a
+ * million Threads need only their stacks.
+ * With several workers, each worker is a kernel thread with a ready deque
+ * of its own: a spawned (or resumed) Thread joins the deque of the worker
+ * that spawned it, and idle workers steal Threads from the other deques.
+ * A worker with nothing to run (its running Thread waits for a mutex or its
+ * next period, and no Thread is READY) sleeps until a Thread is made READY,
+ * the mutex is handed over, a period starts or a signal arrives - it
+ * doesn't spin. The scheduling decisions of all the workers are serialized
+ * by one lock - only taking Threads from the deques, sleeping, waking a
+ * worker and reprogramming its timer are done outside it - so the workers
+ * run their Threads in parallel, but library calls and switches are done
+ * one at a time. The CPU clocks then measure the CPU time of each worker.
+ * Note that the workers make the process multi-threaded, so a Thread
+ * preempted inside a locking libc call (malloc, stdio) may stall the other
+ * Threads of its worker that make the same call.
+ * The policy orders the READY Threads: UTHREAD_POLICY_PRIORITY (see
+ * uthread_set_priority), UTHREAD_POLICY_ROUND_ROBIN (the priorities are
+ * ignored) or UTHREAD_POLICY_FAIR. A library built with
+ * -DUTHREADS_POLICY=<class> (see SchedulerPolicy.h) has only that policy,
+ * and any other is an error.
+ * With UTHREAD_POLICY_FAIR, the CPU time every Thread runs is measured in
+ * nanoseconds, and the READY Thread that ran the least - by its virtual
+ * runtime, the run time divided by the weight of its priority - runs next. A
+ * Thread that blocks early in its quantum is charged only for the time it
+ * ran, and gets ahead of the Threads that use their whole quanta (by at most
+ * half a quantum, for the time it waited) - so Threads that wait often run
+ * soon after they wake up, and the others still get their share. With
+ * several workers the shares are fair among the Threads of each worker.
+ * With adaptive_quantum, a Thread's quantum is quantum_usecs times 4
+ * divided by the number of READY Threads of its worker (rounded up to a
+ * power of 2), but at least a quarter of quantum_usecs and at most 4 times
+ * it - so a READY Thread waits about 4 quantum_usecs for its turn, and few
+ * Threads switch less often.
+ * A quantum set by uthread_set_quantum overrides it.
+ * The clock measures the quanta: UTHREAD_CLOCK_VIRTUAL is the user CPU time
+ * of the process, and UTHREAD_CLOCK_CPU its CPU time by a POSIX timer
+ * (CLOCK_PROCESS_CPUTIME_ID) - both expire only at kernel ticks, so a
+ * quantum shorter than a tick lasts a tick. UTHREAD_CLOCK_MONOTONIC is the
+ * wall-clock time, to the nanosecond - quanta end also while the process
+ * waits for the CPU or in a system call (which is restarted, if it can be),
+ * for Threads bound by latency rather than by CPU. Its timer expires at the
+ * absolute deadline of the quantum, so a switch doesn't reprogram it - it
+ * is moved when it expires early. Its quanta are at least 20 microseconds,
+ * longer than a preemption. quantum_nsecs sets a quantum in nanoseconds
+ * (UTHREAD_CLOCK_VIRTUAL rounds it up to microseconds).
+ * With tickless, the timer of a worker is stopped while no other Thread is
+ * READY on it (and there are no periodic Threads), so a Thread that runs
+ * alone isn't interrupted every quantum. It restarts when a Thread becomes
+ * READY - the running Thread then starts a new quantum. The quantum
+ * counts don't grow while the timer is stopped.
+ * Return value: On success, return 0. On failure, return -1.
+*/
+int uthread_init_ex(int quantum_usecs, const uthread_options_t *options);
+
 /*
  * Description: This function creates a new Thread, whose entry point is the
  * function f with the signature void f(void). The Thread is added to the end
  * of the READY threads list. The uthread_spawn function should fail if it
  * would cause the number of concurrent threads to exceed the limit
- * (MAX_THREAD_NUM). Each Thread should be allocated with a stack of size
- * STACK_SIZE bytes.
+ * (MAX_THREAD_NUM, or the max_threads option of uthread_init_ex). Each
+ * Thread should be allocated with a stack of size STACK_SIZE bytes. It also
+ * fails (and no ID is used) if there is no memory for the stack.
  * Return value: On success, return the ID of the created Thread.
  * On failure, return -1.
 */
 int uthread_spawn(void (*f)(void));
 
 
+/*
+ * Description: This function sets the attributes to their default values
+ * (the values uthread_spawn uses).
+ * Return value: On success, return 0. On failure, return -1.
+*/
+int uthread_attr_init(uthread_attr_t *attrs);
+
+
+/*
+ * Description: This function creates a new Thread like uthread_spawn, with
+ * the given attributes. attrs->stack_size sets the size of the Thread's
+ * stack - it must be 0 (STACK_SIZE) or at least MIN_STACK_SIZE bytes. The
+ * library adds room for the timer signal frame on top of this size.
+ * attrs may be NULL for the default attributes.
+ * Return value: On success, return the ID of the created Thread.
+ * On failure, return -1.
+*/
+int uthread_spawn_ex(void (*f)(void), const uthread_attr_t *attrs);
+
+
+/*
+ * Description: This function creates a new joinable Thread, whose entry
+ * point is the function f with the signature void *f(void *), called with
+ * arg. Its stack is set by attrs as in uthread_spawn_ex. When f returns (or
+ * the Thread calls uthread_exit, or is terminated) the Thread keeps its ID
+ * until another Thread gets the result with uthread_join, unless it was
+ * detached with uthread_detach. The Threads of uthread_spawn and
+ * uthread_spawn_ex are detached.
+ * Return value: On success, return the ID of the created Thread.
+ * On failure, return -1.
+*/
+int uthread_spawn_arg(void *(*f)(void *), void *arg, const uthread_attr_t *attrs);
+
+
+/*
+ * Description: This function creates a new periodic Thread, which runs
+ * f once every period_usecs micro-seconds (a job), starting now. Each job
+ * should run for at most budget_usecs micro-seconds of CPU time, and finish
+ * within deadline_usecs micro-seconds of its start. Periodic Threads run
+ * before all the other Threads, the one with the earliest deadline first.
+ * A job that runs longer than its budget goes on with the budget of the
+ * next period and a deadline one period later, so it can't delay the other
+ * periodic Threads. The budgets are checked at the end of every quantum, so
+ * the quantum should be well below them.
+ * It is an error to give non-positive times, a budget longer than the
+ * deadline, or a deadline longer than the period. The Thread is not
+ * admitted (an error) if the periodic Threads would need more than one CPU
+ * - the sum of budget_usecs / deadline_usecs of all of them must not exceed
+ * 1, so with EDF they all meet their deadlines while they keep to their
+ * budgets.
+ * Return value: On success, return the ID of the created Thread.
+ * On failure, return -1.
+*/
+int uthread_spawn_periodic(void (*f)(void), int period_usecs, int budget_usecs, int deadline_usecs);
+
+
 /*
  * Description: This function terminates the Thread with ID tid and deletes
  * it from all relevant control structures. All the resources allocated by
@@ -53,6 +279,37 @@ int uthread_spawn(void (*f)(void));
 int uthread_terminate(int tid);
 
 
+/*
+ * Description: This function terminates the running Thread, like
+ * uthread_terminate(uthread_get_tid()). If it is joinable, result is what
+ * uthread_join gives the Thread that joins it (a joinable Thread that is
+ * terminated by another Thread gives NULL).
+ * Return value: The function does not return.
+*/
+void uthread_exit(void *result);
+
+
+/*
+ * Description: This function waits for the joinable Thread with ID tid to
+ * terminate, stores its result in *result (if result is not NULL) and frees
+ * it. The calling Thread is not READY while it waits. It is an error to
+ * join a Thread that doesn't exist, is detached, is already joined by
+ * another Thread, joins the calling Thread, or is the calling Thread itself.
+ * Return value: On success, return 0. On failure, return -1.
+*/
+int uthread_join(int tid, void **result);
+
+
+/*
+ * Description: This function detaches the joinable Thread with ID tid - it
+ * is freed as soon as it terminates (at once, if it terminated already),
+ * and can't be joined. It is an error to detach a Thread that doesn't
+ * exist, is already detached, or that another Thread waits to join.
+ * Return value: On success, return 0. On failure, return -1.
+*/
+int uthread_detach(int tid);
+
+
 /*
  * Description: This function blocks the Thread with ID tid. The Thread may
  * be resumed later using uthread_resume. If no Thread with ID tid exists it
@@ -75,12 +332,90 @@ int uthread_block(int tid);
 int uthread_resume(int tid);
 
 
+/*
+ * Description: This function sets the priority of the Thread with ID tid,
+ * from 0 (the most urgent) to PRIORITY_LEVELS - 1. A new Thread has
+ * DEFAULT_PRIORITY. The READY Thread with the most urgent priority runs
+ * next, and Threads of the same priority run in round robin. A Thread that
+ * becomes READY with a more urgent priority than the running Thread
+ * preempts it. With UTHREAD_POLICY_FAIR (see uthread_init_ex) the priority
+ * is a weight instead, like a nice value: every step towards 0 gives the
+ * Thread 1.25 times the CPU share. If no Thread with ID tid exists, or the
+ * priority is out of range, it is considered an error.
+ * Return value: On success, return 0. On failure, return -1.
+*/
+int uthread_set_priority(int tid, int priority);
+
+
+/*
+ * Description: This function returns the priority of the Thread with ID tid.
+ * If no Thread with ID tid exists it is considered an error.
+ * Return value: On success, return the priority. On failure, return -1.
+*/
+int uthread_get_priority(int tid);
+
+
+/*
+ * Description: This function sets the quantum of the Thread with ID tid, in
+ * microseconds - 0 means the quantum of the library (see uthread_init_ex).
+ * It takes effect from the next quantum of the Thread. If no Thread with
+ * ID tid exists, or quantum_usecs is negative, it is considered an error.
+ * Return value: On success, return 0. On failure, return -1.
+*/
+int uthread_set_quantum(int tid, int quantum_usecs);
+
+
+/*
+ * Description: This function returns the quantum set for the Thread with
+ * ID tid by uthread_set_quantum, 0 if it has none. If no Thread with ID tid
+ * exists it is considered an error.
+ * Return value: On success, return the quantum. On failure, return -1.
+*/
+int uthread_get_quantum(int tid);
+
+
+/*
+ * Description: This function moves the running Thread to the end of the
+ * READY threads list and switches to the next READY Thread at once. The
+ * next Thread starts a new quantum, unless the library was initialized with
+ * yield_keeps_quantum - then it runs for the rest of the yielding Thread's
+ * quantum and the timer is not reprogrammed. If no other Thread is READY,
+ * the running Thread continues.
+ * Return value: On success, return 0. On failure, return -1.
+*/
+int uthread_yield();
+
+
+/*
+ * Description: This function puts the running Thread to sleep for usecs
+ * micro-seconds, like uthread_sleep_until. It is an error to give a
+ * negative usecs.
+ * Return value: On success, return 0. On failure, return -1.
+*/
+int uthread_sleep_usec(int usecs);
+
+
+/*
+ * Description: This function puts the running Thread to sleep until
+ * wake_time, an absolute time of CLOCK_MONOTONIC - it waits, and becomes
+ * READY at the first scheduling decision (the end of a quantum, or a
+ * switch) after wake_time; if wake_time passed it returns at once. The
+ * sleeping Threads wait in a timing wheel with ticks of about 65
+ * micro-seconds, so a sleep costs O(1) however many Threads sleep. A
+ * sleeping Thread that is blocked stays BLOCKED when it wakes up, and
+ * uthread_resume doesn't wake it up early. The main Thread may sleep too.
+ * It is an error to give an invalid time.
+ * Return value: On success, return 0. On failure, return -1.
+*/
+int uthread_sleep_until(const struct timespec *wake_time);
+
+
 /*
  * Description: This function tries to acquire a mutex.
  * If the mutex is unlocked, it locks it and returns.
  * If the mutex is already locked by different Thread, the Thread moves to BLOCK state.
- * In the future when this Thread will be back to RUNNING state,
- * it will try again to acquire the mutex.
+ * When the mutex is unlocked it is handed to the first blocked Thread, which
+ * moves to READY state already holding it.
  * If the mutex is already locked by this Thread, it is considered an error.
  * Return value: On success, return 0. On failure, return -1.
 */
@@ -89,14 +424,315 @@ int uthread_mutex_lock();
 
 /*
  * Description: This function releases a mutex.
- * If there are blocked threads waiting for this mutex,
- * one of them (no matter which one) moves to READY state.
+ * If there are blocked threads waiting for this mutex, the first of them
+ * becomes its owner and moves to READY state.
  * If the mutex is already unlocked, it is considered an error.
  * Return value: On success, return 0. On failure, return -1.
 */
 int uthread_mutex_unlock();
 
 
+/*
+ * Description: This function initializes a mutex object, unlocked. A mutex
+ * object must be initialized before any other use. uthread_mutex_lock and
+ * uthread_mutex_unlock use a default mutex object of the library.
+ * Return value: On success, return 0. On failure, return -1.
+*/
+int uthread_mutex_init(uthread_mutex_t *mutex);
+
+
+/*
+ * Description: This function destroys a mutex object. It is an error to
+ * destroy a mutex that is locked or that threads wait for.
+ * Return value: On success, return 0. On failure, return -1.
+*/
+int uthread_mutex_destroy(uthread_mutex_t *mutex);
+
+
+/*
+ * Description: This function acquires the given mutex object, like
+ * uthread_mutex_lock. Each mutex has its own owner and waiting threads.
+ * Return value: On success, return 0. On failure, return -1.
+*/
+int uthread_mutex_lock_ex(uthread_mutex_t *mutex);
+
+
+/*
+ * Description: This function releases the given mutex object, like
+ * uthread_mutex_unlock.
+ * Return value: On success, return 0. On failure, return -1.
+*/
+int uthread_mutex_unlock_ex(uthread_mutex_t *mutex);
+
+
+/*
+ * Description: This function initializes a condition variable object, with
+ * no waiting Threads. It must be initialized before any other use.
+ * Return value: On success, return 0. On failure, return -1.
+*/
+int uthread_cond_init(uthread_cond_t *cond);
+
+
+/*
+ * Description: This function destroys a condition variable object. It is an
+ * error to destroy a condition variable that Threads wait on.
+ * Return value: On success, return 0. On failure, return -1.
+*/
+int uthread_cond_destroy(uthread_cond_t *cond);
+
+
+/*
+ * Description: This function releases the mutex (NULL for the mutex of
+ * uthread_mutex_lock), which the running Thread holds, and waits on the
+ * condition variable, in one step - a signal sent after the mutex is
+ * released is not lost. The Thread is not READY while it waits, and returns
+ * once it was signalled and holds the mutex again (there are no spurious
+ * wakeups, but the condition may have changed again by then). It is an
+ * error to wait without holding the mutex, or with another mutex than the
+ * other waiting Threads.
+ * Return value: On success, return 0. On failure, return -1.
+*/
+int uthread_cond_wait(uthread_cond_t *cond, uthread_mutex_t *mutex);
+
+
+/*
+ * Description: This function wakes the first Thread that waits on the
+ * condition variable, if any. It moves straight to the waiters of the
+ * mutex (or gets the mutex, if it is unlocked), so it becomes READY only
+ * when the mutex is handed to it.
+ * Return value: On success, return 0. On failure, return -1.
+*/
+int uthread_cond_signal(uthread_cond_t *cond);
+
+
+/*
+ * Description: This function wakes all the Threads that wait on the
+ * condition variable, like uthread_cond_signal - they join the waiters of
+ * the mutex in their order and get it one by one, instead of all becoming
+ * READY to compete for it.
+ * Return value: On success, return 0. On failure, return -1.
+*/
+int uthread_cond_broadcast(uthread_cond_t *cond);
+
+
+/*
+ * The semaphores, barriers, latches, wait groups and reader-writer locks
+ * below park a waiting Thread in a queue of the object - it is not READY
+ * while it waits, and is woken once, when its wait ends. A waiting Thread
+ * that is blocked stays BLOCKED when its wait ends, and uthread_resume
+ * doesn't end its wait. A waiting Thread that is terminated leaves the
+ * queue. A Thread that is terminated while it holds reader-writer locks
+ * releases them, like the mutexes it holds - but the units it took from a
+ * semaphore are not given back, since a semaphore has no owner (post them
+ * before the Thread terminates). Each object must be initialized before
+ * any other use.
+ */
+
+/*
+ * Description: This function initializes a counting semaphore object with
+ * value units. It is an error to give a negative value.
+ * Return value: On success, return 0. On failure, return -1.
+*/
+int uthread_sem_init(uthread_sem_t *sem, int value);
+
+
+/*
+ * Description: This function destroys a semaphore object. It is an error to
+ * destroy a semaphore that Threads wait for.
+ * Return value: On success, return 0. On failure, return -1.
+*/
+int uthread_sem_destroy(uthread_sem_t *sem);
+
+
+/*
+ * Description: This function takes a unit of the semaphore. If there is
+ * none, the Thread waits for uthread_sem_post, which hands its unit
+ * directly to the first waiting Thread.
+ * Return value: On success, return 0. On failure, return -1.
+*/
+int uthread_sem_wait(uthread_sem_t *sem);
+
+
+/*
+ * Description: This function takes a unit of the semaphore, if there is
+ * one, without waiting.
+ * Return value: If a unit was taken, return 0. If there was none, return 1.
+ * On failure, return -1.
+*/
+int uthread_sem_trywait(uthread_sem_t *sem);
+
+
+/*
+ * Description: This function gives a unit back to the semaphore - to the
+ * first waiting Thread, which becomes READY, if there is one.
+ * Return value: On success, return 0. On failure, return -1.
+*/
+int uthread_sem_post(uthread_sem_t *sem);
+
+
+/*
+ * Description: This function returns the number of units of the semaphore
+ * (0 while Threads wait for it).
+ * Return value: On success, return the number of units. On failure, return -1.
+*/
+int uthread_sem_getvalue(uthread_sem_t *sem);
+
+
+/*
+ * Description: This function initializes a barrier object for count
+ * Threads. It is an error to give a count smaller than 1.
+ * Return value: On success, return 0. On failure, return -1.
+*/
+int uthread_barrier_init(uthread_barrier_t *barrier, int count);
+
+
+/*
+ * Description: This function destroys a barrier object. It is an error to
+ * destroy a barrier that Threads wait at.
+ * Return value: On success, return 0. On failure, return -1.
+*/
+int uthread_barrier_destroy(uthread_barrier_t *barrier);
+
+
+/*
+ * Description: This function waits at the barrier until count Threads
+ * arrived - the last of them wakes the others and goes on, and the barrier
+ * is ready for the next round.
+ * Return value: On success, return UTHREAD_BARRIER_SERIAL_THREAD for the
+ * last Thread to arrive, and 0 for the others. On failure, return -1.
+*/
+int uthread_barrier_wait(uthread_barrier_t *barrier);
+
+
+/*
+ * Description: This function initializes a latch object (a one-shot count
+ * down) with count. It is an error to give a negative count.
+ * Return value: On success, return 0. On failure, return -1.
+*/
+int uthread_latch_init(uthread_latch_t *latch, int count);
+
+
+/*
+ * Description: This function destroys a latch object. It is an error to
+ * destroy a latch that Threads wait for.
+ * Return value: On success, return 0. On failure, return -1.
+*/
+int uthread_latch_destroy(uthread_latch_t *latch);
+
+
+/*
+ * Description: This function decrements the count of the latch, and wakes
+ * the waiting Threads when it reaches zero. It is an error to count down a
+ * latch whose count is zero.
+ * Return value: On success, return 0. On failure, return -1.
+*/
+int uthread_latch_count_down(uthread_latch_t *latch);
+
+
+/*
+ * Description: This function waits until the count of the latch is zero
+ * (returns at once if it is).
+ * Return value: On success, return 0. On failure, return -1.
+*/
+int uthread_latch_wait(uthread_latch_t *latch);
+
+
+/*
+ * Description: This function initializes a wait group object, with a count
+ * of 0. Like a latch, but its count may also go up, so it may be waited for
+ * again.
+ * Return value: On success, return 0. On failure, return -1.
+*/
+int uthread_waitgroup_init(uthread_waitgroup_t *group);
+
+
+/*
+ * Description: This function destroys a wait group object. It is an error
+ * to destroy a wait group that Threads wait for.
+ * Return value: On success, return 0. On failure, return -1.
+*/
+int uthread_waitgroup_destroy(uthread_waitgroup_t *group);
+
+
+/*
+ * Description: This function adds delta (may be negative) to the count of
+ * the wait group - usually the number of Threads about to be started - and
+ * wakes the waiting Threads when it reaches zero. It is an error to make
+ * the count negative.
+ * Return value: On success, return 0. On failure, return -1.
+*/
+int uthread_waitgroup_add(uthread_waitgroup_t *group, int delta);
+
+
+/*
+ * Description: This function decrements the count of the wait group, like
+ * uthread_waitgroup_add(group, -1) - usually when a Thread finished.
+ * Return value: On success, return 0. On failure, return -1.
+*/
+int uthread_waitgroup_done(uthread_waitgroup_t *group);
+
+
+/*
+ * Description: This function waits until the count of the wait group is
+ * zero (returns at once if it is).
+ * Return value: On success, return 0. On failure, return -1.
+*/
+int uthread_waitgroup_wait(uthread_waitgroup_t *group);
+
+
+/*
+ * Description: This function initializes a reader-writer lock object - held
+ * by any number of readers, or by one writer. If prefer_writers is not 0, a
+ * new reader waits while a writer waits, so a stream of readers can't keep
+ * the writers waiting forever. Otherwise a new reader takes the lock
+ * whenever readers hold it, which gives the most read concurrency.
+ * Return value: On success, return 0. On failure, return -1.
+*/
+int uthread_rwlock_init(uthread_rwlock_t *rwlock, int prefer_writers);
+
+
+/*
+ * Description: This function destroys a reader-writer lock object. It is an
+ * error to destroy a lock that is held, or that Threads wait for.
+ * Return value: On success, return 0. On failure, return -1.
+*/
+int uthread_rwlock_destroy(uthread_rwlock_t *rwlock);
+
+
+/*
+ * Description: This function takes the reader-writer lock for reading. The
+ * Thread waits while a writer holds the lock (or, with writer preference,
+ * waits for it). It is an error to take it while holding it for writing,
+ * or while holding MAX_HELD_RWLOCKS other reader-writer locks.
+ * A Thread may hold it for reading several times, and releases it as many
+ * times.
+ * Return value: On success, return 0. On failure, return -1.
+*/
+int uthread_rwlock_rdlock(uthread_rwlock_t *rwlock);
+
+
+/*
+ * Description: This function takes the reader-writer lock for writing. The
+ * Thread waits while any Thread holds the lock. It is an error to take it
+ * while holding it (for writing or for reading), or while holding
+ * MAX_HELD_RWLOCKS other reader-writer locks.
+ * Return value: On success, return 0. On failure, return -1.
+*/
+int uthread_rwlock_wrlock(uthread_rwlock_t *rwlock);
+
+
+/*
+ * Description: This function releases the reader-writer lock, which the
+ * calling Thread holds for writing or for reading. If that frees the lock,
+ * it is handed to the waiting Threads: when a writer releases it, all the
+ * waiting readers get it at once (or, if none wait, the first writer), and
+ * when the last reader releases it, the first waiting writer gets it. It is
+ * an error to release a lock the calling Thread doesn't hold.
+ * Return value: On success, return 0. On failure, return -1.
+*/
+int uthread_rwlock_unlock(uthread_rwlock_t *rwlock);
+
+
 /*
  * Description: This function returns the Thread ID of the calling Thread.
  * Return value: The ID of the calling Thread.
@@ -127,5 +763,36 @@ int uthread_get_total_quantums();
 */
 int uthread_get_quantums(int tid);
 
+
+/*
+ * Description: This function returns the CPU time the Thread with ID tid
+ * ran, in nanoseconds (including the current quantum if it is RUNNING).
+ * The run time is measured only with UTHREAD_POLICY_FAIR (see
+ * uthread_init_ex), or since the first periodic Thread was spawned. If no
+ * Thread with ID tid exists it is considered an error.
+ * Return value: On success, return the run time of the Thread with ID tid.
+ * 			     On failure, return -1.
+*/
+long long uthread_get_run_time(int tid);
+
+
+/*
+ * Description: This function fills stats with the statistics of the
+ * periodic Thread with ID tid (see uthread_spawn_periodic). It is an error
+ * if no Thread with ID tid exists, or if it is not periodic.
+ * Return value: On success, return 0. On failure, return -1.
+*/
+int uthread_get_periodic_stats(int tid, uthread_periodic_stats_t *stats);
+
+
+/*
+ * Description: This function fills stats with the statistics of the
+ * scheduler since uthread_init - the switch rate is switches divided by
+ * elapsed_usecs. The latency (from becoming READY to running) is measured
+ * only if the library was initialized with sched_stats.
+ * Return value: On success, return 0. On failure, return -1.
+*/
+int uthread_get_sched_stats(uthread_sched_stats_t *stats);
+
 #endif
 